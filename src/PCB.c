@@ -12,22 +12,48 @@
 #include "PCB.h"
 #include "kernel.h"
 #include "blocks.h"
+#include "slab.h"
+
+/*
+ * A PCB and the contexts and block it points to, allocated together so a
+ * process is one object from one cache. The PCB must come first so the
+ * PCB pointer is also the pointer to the whole thing.
+ */
+typedef struct proc_obj_t {
+  PCB_t pcb;
+  UserContext uc;
+  KernelContext kc;
+  block_t block;
+} proc_obj_t;
+
+static slab_cache_t proc_cache = SLAB_CACHE("proc", sizeof(proc_obj_t));
+static slab_cache_t r0_pt_cache = SLAB_CACHE("r0_pt", KS_NPG * sizeof(struct pte));
+static slab_cache_t r1_pt_cache = SLAB_CACHE("r1_pt", VMEM_1_PAGE_COUNT * sizeof(struct pte));
+static slab_cache_t r1_info_cache = SLAB_CACHE("r1_info", VMEM_1_PAGE_COUNT * sizeof(page_info_t));
 
 PCB_t *new_process(UserContext *uc) {   
   TracePrintf(1, "Start: new_process\n");
   
-  // Allocate a new Process Control Block
-  PCB_t *pcb = (PCB_t *) malloc( sizeof(PCB_t) );
-  
-  // Allocate a new UserContext for the PCB
-  pcb->uc = (UserContext *) malloc( sizeof(UserContext) );
+  // Allocate the PCB along with its UserContext, KernelContext and Block
+  proc_obj_t *obj = (proc_obj_t *) slab_alloc(&proc_cache);
+  PCB_t *pcb;
 
-  // Allocate a new KernelContext for the PCB
-  pcb->kc_p = (KernelContext *) malloc(sizeof(KernelContext));
+  if (obj == NULL) {
+    TracePrintf(3, "new_process: out of kernel heap\n");
+    return NULL;
+  }
+  pcb = &obj->pcb;
+  pcb->uc = &obj->uc;
+  pcb->kc_p = &obj->kc;
+  pcb->block = &obj->block;
 
-  // Allocate a new Block for the PCB
-  pcb->block = (block_t *) malloc( sizeof(block_t) );
-  bzero((char *)pcb->block, sizeof(block_t) );
+  // Allocate the software page info for region 1 (all flags clear)
+  pcb->region1_info = (page_info_t *) slab_alloc(&r1_info_cache);
+  if (pcb->region1_info == NULL) {
+    TracePrintf(3, "new_process: out of kernel heap\n");
+    slab_free(&proc_cache, obj);
+    return NULL;
+  }
 
   // UserContext inherits the vector and code from 
   pcb->uc->vector = uc->vector;
@@ -44,12 +70,71 @@ PCB_t *new_process(UserContext *uc) {
   pcb->heap_base_page = 0;
   pcb->brk_addr = 0;
   pcb->kc_set = 0;
+  pcb->exec_fd = -1;
+  pcb->data_end = 0;
+  pcb->text = NULL;
+  pcb->chk_lo = 0;
+  pcb->chk_hi = 0;
+  pcb->chk_prot = 0;
+  pcb->read_len = 0;
+  pcb->read_buf = NULL;
+  pcb->read_got = 0;
+  pcb->write_len = 0;
+  pcb->ipc_state = IPC_NONE;
+  pcb->ipc_peer = -1;
+  pcb->ipc_buf = NULL;
+  pcb->ipc_result = 0;
+  init_queue(&pcb->ipc_senders);
+  pcb->q_next = NULL;
+  pcb->q_prev = NULL;
+  pcb->q_on = NULL;
+  pcb->sched_level = 0;
+  pcb->sched_ticks = 0;
+
+  bzero((char *) &pcb->stats, sizeof(pstats_t));
+  pcb->stats.pid = pcb->proc_id;
+  pcb->stat_state = STATE_READY;
+  pcb->stat_since = current_tick;
 
-  pcb->write_buf = (buffer *)malloc(sizeof(buffer));
-  pcb->write_buf->buf = NULL;
-  pcb->write_buf->len = 0;
-  
   TracePrintf(1, "End: new_process\n");
 
   return pcb;
 }
+
+/*
+ * Function: alloc_page_tables
+ *  @pcb: a process from new_process() that has no page tables yet
+ *
+ * Allocates the process' kernel stack and region 1 page tables, both
+ * zeroed (so every page starts out invalid).
+ *
+ * Returns SUCCESS, or ERROR if the kernel heap ran out.
+ */
+int alloc_page_tables(PCB_t *pcb) {
+  pcb->region0_pt = (struct pte *) slab_alloc(&r0_pt_cache);
+  pcb->region1_pt = (struct pte *) slab_alloc(&r1_pt_cache);
+
+  if (pcb->region0_pt == NULL || pcb->region1_pt == NULL) {
+    slab_free(&r0_pt_cache, pcb->region0_pt);
+    slab_free(&r1_pt_cache, pcb->region1_pt);
+    pcb->region0_pt = NULL;
+    pcb->region1_pt = NULL;
+    return ERROR;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: free_process
+ *  @pcb: a process from new_process()
+ *
+ * Gives back the PCB, its contexts, and its page tables. The frames the
+ * page tables map must already have been freed.
+ */
+void free_process(PCB_t *pcb) {
+  slab_free(&r0_pt_cache, pcb->region0_pt);
+  slab_free(&r1_pt_cache, pcb->region1_pt);
+  slab_free(&r1_info_cache, pcb->region1_info);
+  slab_free(&proc_cache, pcb);
+}
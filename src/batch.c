@@ -0,0 +1,120 @@
+/*
+ * File: batch.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the batch syscall described in batch.h. Each entry
+ *    is run through the same argument checks and dispatch as a trapped
+ *    syscall (do_syscall()), using a UserContext that's a copy of the
+ *    batch trap's with the entry's code and arguments in place.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "traps.h"
+#include "syscalls.h"
+#include "stats.h"
+#include "batch.h"
+
+/*
+ * Private Function Definitions
+ */
+
+/*
+ * Function: batchable
+ *  @code: a syscall code
+ *
+ * Returns nonzero if the syscall can run inside a batch.
+ */
+static int batchable(int code) {
+  switch ((unsigned int) code) {
+    case YALNIX_GETPID:
+    case YALNIX_DELAY:
+    case YALNIX_TTY_READ:
+    case YALNIX_TTY_WRITE:
+    case YALNIX_LOCK_INIT:
+    case YALNIX_LOCK_ACQUIRE:
+    case YALNIX_LOCK_RELEASE:
+    case YALNIX_CVAR_INIT:
+    case YALNIX_CVAR_SIGNAL:
+    case YALNIX_CVAR_BROADCAST:
+    case YALNIX_CVAR_WAIT:
+    case YALNIX_PIPE_INIT:
+    case YALNIX_PIPE_READ:
+    case YALNIX_PIPE_WRITE:
+    case YALNIX_SEM_INIT:
+    case YALNIX_SEM_UP:
+    case YALNIX_SEM_DOWN:
+    case YALNIX_REGISTER:
+    case YALNIX_SEND:
+    case YALNIX_RECEIVE:
+    case YALNIX_RECEIVESPECIFIC:
+    case YALNIX_REPLY:
+    case YALNIX_FORWARD:
+    case YALNIX_READ_SECTOR:
+    case YALNIX_WRITE_SECTOR:
+    case YALNIX_SYNC:
+    case YALNIX_RECLAIM:
+    case YALNIX_STATS:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: Yalnix_Batch
+ *  @uc: the UserContext of the batch trap
+ *  @ops: the caller's array of entries, already validated
+ *  @count: number of entries
+ *  @flags: BATCH_* flags
+ *
+ * Returns the number of entries run, or ERROR if count is out of range.
+ */
+int Yalnix_Batch(UserContext *uc, batch_op_t *ops, int count, int flags) {
+  UserContext op_uc;
+  int i;
+
+  if (count < 0 || count > BATCH_MAX)
+    return ERROR;
+
+  for (i = 0; i < count; i++) {
+    if (ops[i].code == BATCH_NOP) {
+      ops[i].result = 0;
+    } else if (!batchable(ops[i].code)) {
+      TracePrintf(3, "Yalnix_Batch: syscall %x can't be batched\n", ops[i].code);
+      ops[i].result = ERROR;
+    } else {
+      // Each entry gets its own context so a blocking one can't clobber
+      // the batch trap's
+      op_uc = *uc;
+      op_uc.code = ops[i].code;
+      op_uc.regs[0] = ops[i].args[0];
+      op_uc.regs[1] = ops[i].args[1];
+      op_uc.regs[2] = ops[i].args[2];
+
+      stats_syscall(curr_proc, op_uc.code);
+      ops[i].result = do_syscall(&op_uc);
+    }
+
+    if ((flags & BATCH_STOP_ON_ERROR) && ops[i].result == ERROR)
+      return i + 1;
+  }
+
+  return count;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:  batch.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Batched syscalls. A user program fills in an array of batch_op_t and
+ *    traps once to run them all, in order:
+ *
+ *        batch_op_t ops[2] = {
+ *          { YALNIX_PIPE_WRITE, { pipe_id, (int) buf, len } },
+ *          { YALNIX_TTY_WRITE, { 0, (int) msg, msg_len } },
+ *        };
+ *        Custom1((int) ops, 2, BATCH_STOP_ON_ERROR, 0);
+ *
+ *    Each entry's result is written back to it. Custom1 returns how many
+ *    entries were run, or ERROR if the array itself is bad. Only the
+ *    syscalls that don't replace or end the caller and take at most three
+ *    arguments can be batched (so not Fork, Exec, Exit, Wait, Brk,
+ *    CopyFrom, CopyTo, or another batch); any other code fails with
+ *    ERROR. BATCH_NOP does nothing and returns 0.
+ *
+ *    This header has no kernel dependencies so that user programs can
+ *    include it too.
+ *
+ * Contents:
+ *    YALNIX_BATCH        - The batch trap code
+ *    BATCH_*             - Flags and limits
+ *    batch_op_t          - One batched syscall
+ *
+ * Warnings:
+ *    A syscall that blocks blocks the whole batch.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+/*
+ * Public Constant Definitions
+ */
+#define YALNIX_BATCH          YALNIX_CUSTOM_1
+#define BATCH_NOP             0       // Entry code that does nothing
+#define BATCH_MAX             256     // Most entries in one batch
+
+// Flags
+#define BATCH_STOP_ON_ERROR   0x1     // Stop at the first entry that fails
+
+/*
+ * batch_op_t datatype
+ *
+ * One syscall in a batch: its code and arguments as they'd be passed in
+ * registers, and room for its return value.
+ */
+typedef struct batch_op_t {
+  int code;           // YALNIX_* code of the syscall, or BATCH_NOP
+  int args[3];        // Its arguments
+  int result;         // Filled in with its return value
+} batch_op_t;
+
+#endif // _BATCH_H_
@@ -0,0 +1,398 @@
+/*
+ * File: bcache.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the buffer cache declared in bcache.h. Every
+ *    buffer is on the LRU list (most recently used at the head) and, if
+ *    it holds a sector, on that sector's hash chain. A buffer is busy
+ *    while a process is using it across a disk access; anyone else who
+ *    wants it waits on the buffer and looks the sector up again once
+ *    it's released, since the buffer may have been reused by then.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "disk.h"
+#include "syscalls.h"
+#include "bcache.h"
+
+/*
+ * Private Constant Definitions
+ */
+// Buffer flags
+#define BUF_VALID     0x1     // data holds the sector
+#define BUF_DIRTY     0x2     // data is newer than the disk
+#define BUF_BUSY      0x4     // In use across a disk access
+
+/*
+ * Private Types
+ */
+typedef struct bbuf_t {
+  int sector;                 // Sector held, or -1
+  int flags;                  // BUF_* flags
+  char *data;                 // SECTORSIZE bytes in the cache window
+  struct bbuf_t *hnext;       // Next buffer on the same hash chain
+  struct bbuf_t *prev;        // LRU neighbours
+  struct bbuf_t *next;
+  proc_queue_t waiters;       // Processes waiting for it to stop being busy
+} bbuf_t;
+
+/*
+ * Private Variables
+ */
+static bbuf_t *bcache_bufs;       // All the buffers
+static int bcache_nbufs;
+static bbuf_t **bcache_hash;      // Hash chains, by sector
+static int bcache_nhash;          // Number of chains, a power of two
+static bbuf_t bcache_lru;         // Head of the circular LRU list
+static int *bcache_fnums;         // Frames holding the buffers
+static int bcache_nframes;
+static int bcache_low_page = SCRATCH_PAGE;  // First page of the cache window
+
+/*
+ * Private Function Definitions
+ */
+
+/*
+ * Function: bcache_lookup
+ *  @sector: a sector number
+ *
+ * Returns the buffer holding the sector, or NULL.
+ */
+static bbuf_t *bcache_lookup(int sector) {
+  bbuf_t *b;
+
+  for (b = bcache_hash[sector & (bcache_nhash - 1)]; b != NULL; b = b->hnext) {
+    if (b->sector == sector)
+      return b;
+  }
+
+  return NULL;
+}
+
+/*
+ * Function: bcache_rehash
+ *  @b: a buffer that isn't busy
+ *  @sector: the sector it will hold, or -1
+ */
+static void bcache_rehash(bbuf_t *b, int sector) {
+  bbuf_t **link;
+
+  if (b->sector >= 0) {
+    link = &bcache_hash[b->sector & (bcache_nhash - 1)];
+    while (*link != b)
+      link = &(*link)->hnext;
+    *link = b->hnext;
+  }
+
+  b->sector = sector;
+  b->hnext = NULL;
+  if (sector >= 0) {
+    link = &bcache_hash[sector & (bcache_nhash - 1)];
+    b->hnext = *link;
+    *link = b;
+  }
+}
+
+/*
+ * Function: bcache_touch
+ *  @b: a buffer that was just used
+ *
+ * Moves it to the most recently used end of the LRU list.
+ */
+static void bcache_touch(bbuf_t *b) {
+  b->prev->next = b->next;
+  b->next->prev = b->prev;
+
+  b->next = bcache_lru.next;
+  b->prev = &bcache_lru;
+  bcache_lru.next->prev = b;
+  bcache_lru.next = b;
+}
+
+/*
+ * Function: bcache_release
+ *  @b: a busy buffer
+ *
+ * Clears BUF_BUSY and wakes everyone waiting for it.
+ */
+static void bcache_release(bbuf_t *b) {
+  PCB_t *waiter;
+
+  b->flags &= ~BUF_BUSY;
+  while ((waiter = dequeue(&b->waiters)) != NULL)
+    make_ready(waiter, SCHED_WAKE_IO);
+}
+
+/*
+ * Function: bcache_wait
+ *  @b: a busy buffer
+ */
+static void bcache_wait(bbuf_t *b) {
+  enqueue(&b->waiters, curr_proc);
+  switch_to_next_available_proc(curr_proc->uc, 0);
+}
+
+/*
+ * Function: bcache_get
+ *  @sector: a valid sector number
+ *
+ * Finds the sector's buffer, or reuses the least recently used buffer
+ * for it (writing back what was there if it was dirty). Either way the
+ * buffer comes back busy; it's only BUF_VALID if the sector was cached.
+ *
+ * Returns the buffer, or NULL if every buffer is busy.
+ */
+static bbuf_t *bcache_get(int sector) {
+  bbuf_t *b;
+  int old_sector;
+
+  while ((b = bcache_lookup(sector)) != NULL && (b->flags & BUF_BUSY))
+    bcache_wait(b);
+
+  if (b != NULL) {
+    kstats.bcache_hits++;
+    b->flags |= BUF_BUSY;
+    bcache_touch(b);
+    return b;
+  }
+
+  kstats.bcache_misses++;
+  for (b = bcache_lru.prev; b != &bcache_lru && (b->flags & BUF_BUSY); b = b->prev)
+    ;
+  if (b == &bcache_lru)
+    return NULL;
+
+  // Claim it for the new sector first, so nobody else misses on it too.
+  // Anyone who reads the old sector meanwhile gets the write-back's data
+  // from the disk queue.
+  old_sector = b->sector;
+  bcache_rehash(b, sector);
+  bcache_touch(b);
+
+  if (b->flags & BUF_DIRTY) {
+    b->flags = BUF_BUSY;
+    kstats.bcache_writebacks++;
+    if (disk_io(DISK_WRITE, old_sector, b->data) != SUCCESS)
+      TracePrintf(0, "bcache_get: lost the write-back of sector %d\n", old_sector);
+  }
+
+  b->flags = BUF_BUSY;
+  return b;
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_bcache
+ *  @nframes: number of frames to hold the buffers
+ *
+ * Takes the frames (fewer if the frame allocator or the region 0 window
+ * can't spare that many) and sets up the buffers. A cache with no frames
+ * passes every access straight to the disk.
+ *
+ * Returns SUCCESS, or ERROR if the bookkeeping couldn't be allocated.
+ */
+int init_bcache(int nframes) {
+  int heap_top = UP_TO_PAGE(kernel_brk) >> PAGESHIFT;
+  int i;
+
+  // Leave the kernel heap at least as much room as the cache takes
+  if (nframes < 0)
+    nframes = 0;
+  if (nframes > (SCRATCH_PAGE - heap_top) / 2)
+    nframes = (SCRATCH_PAGE - heap_top) / 2;
+
+  bcache_nbufs = nframes * SECTORS_PER_FRAME;
+  for (bcache_nhash = 1; bcache_nhash < bcache_nbufs; bcache_nhash <<= 1)
+    ;
+
+  bcache_bufs = (bbuf_t *) malloc((bcache_nbufs + 1) * sizeof(bbuf_t));
+  bcache_hash = (bbuf_t **) calloc(bcache_nhash, sizeof(bbuf_t *));
+  bcache_fnums = (int *) malloc((nframes + 1) * sizeof(int));
+  if (bcache_bufs == NULL || bcache_hash == NULL || bcache_fnums == NULL) {
+    TracePrintf(0, "init_bcache: failed to allocate the buffers\n");
+    return ERROR;
+  }
+
+  for (bcache_nframes = 0; bcache_nframes < nframes; bcache_nframes++) {
+    if ((bcache_fnums[bcache_nframes] = alloc_frame()) == ERROR)
+      break;
+  }
+  bcache_nbufs = bcache_nframes * SECTORS_PER_FRAME;
+  bcache_low_page = SCRATCH_PAGE - bcache_nframes;
+
+  bcache_lru.next = &bcache_lru;
+  bcache_lru.prev = &bcache_lru;
+  for (i = 0; i < bcache_nbufs; i++) {
+    bcache_bufs[i].sector = -1;
+    bcache_bufs[i].flags = 0;
+    bcache_bufs[i].data = (char *) (bcache_low_page << PAGESHIFT) + i * SECTORSIZE;
+    bcache_bufs[i].hnext = NULL;
+    init_queue(&bcache_bufs[i].waiters);
+
+    bcache_bufs[i].next = &bcache_lru;
+    bcache_bufs[i].prev = bcache_lru.prev;
+    bcache_lru.prev->next = bcache_bufs + i;
+    bcache_lru.prev = bcache_bufs + i;
+  }
+
+  TracePrintf(1, "init_bcache: %d buffers in %d frames\n", bcache_nbufs, bcache_nframes);
+  return SUCCESS;
+}
+
+/*
+ * Function: bcache_map
+ *
+ * Maps the cache's frames into region 0. Called once r0_pagetable has
+ * been built, before virtual memory is enabled.
+ */
+void bcache_map() {
+  int i;
+
+  for (i = 0; i < bcache_nframes; i++) {
+    r0_pagetable[bcache_low_page + i].valid = (u_long) 0x1;
+    r0_pagetable[bcache_low_page + i].prot = (u_long) (PROT_READ | PROT_WRITE);
+    r0_pagetable[bcache_low_page + i].pfn = FNUM_TO_PFN(bcache_fnums[i]);
+  }
+}
+
+/*
+ * Function: bcache_limit
+ *
+ * Returns the lowest address of the cache window; the kernel break can't
+ * go past it.
+ */
+void *bcache_limit() {
+  return (void *) (bcache_low_page << PAGESHIFT);
+}
+
+/*
+ * Function: bcache_read
+ *  @sector: the sector to read
+ *  @buf: SECTORSIZE bytes in the current process or the kernel
+ *
+ * Returns SUCCESS, or ERROR.
+ */
+int bcache_read(int sector, void *buf) {
+  bbuf_t *b;
+
+  if (sector < 0 || sector >= NUMSECTORS || bcache_nbufs == 0)
+    return disk_io(DISK_READ, sector, buf);
+
+  if ((b = bcache_get(sector)) == NULL)
+    return disk_io(DISK_READ, sector, buf);
+
+  if (!(b->flags & BUF_VALID)) {
+    if (disk_io(DISK_READ, sector, b->data) != SUCCESS) {
+      bcache_rehash(b, -1);
+      bcache_release(b);
+      return ERROR;
+    }
+    b->flags |= BUF_VALID;
+  }
+
+  memcpy(buf, b->data, SECTORSIZE);
+  bcache_release(b);
+  return SUCCESS;
+}
+
+/*
+ * Function: bcache_write
+ *  @sector: the sector to write
+ *  @buf: SECTORSIZE bytes in the current process or the kernel
+ *
+ * Only blocks if a dirty buffer has to be written back to make room.
+ *
+ * Returns SUCCESS, or ERROR.
+ */
+int bcache_write(int sector, void *buf) {
+  bbuf_t *b;
+
+  if (sector < 0 || sector >= NUMSECTORS || bcache_nbufs == 0)
+    return disk_io(DISK_WRITE, sector, buf);
+
+  if ((b = bcache_get(sector)) == NULL)
+    return disk_io(DISK_WRITE, sector, buf);
+
+  memcpy(b->data, buf, SECTORSIZE);
+  b->flags |= BUF_VALID | BUF_DIRTY;
+  bcache_release(b);
+  return SUCCESS;
+}
+
+/*
+ * Function: bcache_sync
+ *
+ * Returns SUCCESS once every sector dirty when it was called is on the
+ * disk, or ERROR if any write failed.
+ */
+int bcache_sync() {
+  bbuf_t *b;
+  int result = SUCCESS;
+  int i;
+
+  for (i = 0; i < bcache_nbufs; i++) {
+    b = bcache_bufs + i;
+
+    while ((b->flags & BUF_DIRTY) && (b->flags & BUF_BUSY))
+      bcache_wait(b);
+    if (!(b->flags & BUF_DIRTY))
+      continue;
+
+    b->flags = (b->flags | BUF_BUSY) & ~BUF_DIRTY;
+    kstats.bcache_writebacks++;
+    if (disk_io(DISK_WRITE, b->sector, b->data) != SUCCESS)
+      result = ERROR;
+    bcache_release(b);
+  }
+
+  return result;
+}
+
+/*
+ * Function: Yalnix_ReadSector
+ *  @sector: the sector to read
+ *  @buf: SECTORSIZE bytes to read it into
+ *
+ * Returns 0, or ERROR.
+ */
+int Yalnix_ReadSector(int sector, void *buf) {
+  return bcache_read(sector, buf);
+}
+
+/*
+ * Function: Yalnix_WriteSector
+ *  @sector: the sector to write
+ *  @buf: SECTORSIZE bytes to write to it
+ *
+ * Returns 0, or ERROR.
+ */
+int Yalnix_WriteSector(int sector, void *buf) {
+  return bcache_write(sector, buf);
+}
+
+/*
+ * Function: Yalnix_Sync
+ *
+ * Returns 0, or ERROR if a sector couldn't be written.
+ */
+int Yalnix_Sync() {
+  return bcache_sync();
+}
@@ -0,0 +1,54 @@
+/*
+ * File:  bcache.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The sector buffer cache that ReadSector and WriteSector go through.
+ *    Its buffers live in frames taken from the frame allocator at boot
+ *    (bcache_frames of them, set with the -bcache kernel option) and
+ *    mapped in a window of region 0 just below the scratch page, so the
+ *    kernel heap has to stay under bcache_limit().
+ *
+ *    Sectors are found through a hash table on the sector number, and
+ *    the least recently used buffer is the one reused on a miss. Writes
+ *    only dirty the buffer; dirty sectors go to the disk when their
+ *    buffer is reused or on an explicit sync (Custom2).
+ *
+ * Contents:
+ *    YALNIX_SYNC         - The sync trap code
+ *    init_bcache()       - Take the frames and set up the buffers
+ *    bcache_map()        - Map the buffers into region 0
+ *    bcache_limit()      - Lowest address used by the buffers
+ *    bcache_read()       - Read a sector through the cache
+ *    bcache_write()      - Write a sector into the cache
+ *    bcache_sync()       - Write every dirty sector to the disk
+ *
+ * Warnings:
+ *    Everything here can block the current process on the disk.
+ *    Written sectors only survive a halt if they've been synced; Exit
+ *    syncs when init or the last user process exits. bcache_sync()
+ *    blocks on the disk, so it can't be called once nothing else can run.
+ */
+
+#ifndef _BCACHE_H_
+#define _BCACHE_H_
+
+/*
+ * Public Constant Definitions
+ */
+#define YALNIX_SYNC             YALNIX_CUSTOM_2
+#define BCACHE_DEFAULT_FRAMES   4       // 64 sectors
+#define SECTORS_PER_FRAME       (PAGESIZE / SECTORSIZE)
+
+/*
+ * Public Prototypes
+ */
+int init_bcache(int nframes);
+void bcache_map();
+void *bcache_limit();
+int bcache_read(int sector, void *buf);
+int bcache_write(int sector, void *buf);
+int bcache_sync();
+
+#endif // _BCACHE_H_
@@ -17,6 +17,7 @@
 #include <yalnix.h>
 
 /* Local Includes */
+#include "kernel.h"
 #include "blocks.h"
 #include "PCB.h"
 #include "linked_list.h"
@@ -31,7 +32,6 @@ int check_block(block_t *block) {
   /*
    * Local Variables
    */
-  unsigned int delay_clock_ticks;
   PCB_t *blocked_proc;
 
   /* If the block is inactive, return indicating UNBLOCKED */
@@ -51,18 +51,12 @@ int check_block(block_t *block) {
       return(UNBLOCKED);
       break;
 
-    // Check and decrement the length of the delay.
-    // Modify active field and return as appropriate
+    // Check whether the wake tick has come yet.
     // Upon finishing, the block is zerod out (no data stored)
     case DELAY_BLOCK :
-      delay_clock_ticks = (unsigned int) block->data.delay_count;
-      
-      if (delay_clock_ticks > 1) { // Still Counting down
-        // Decrement the count and return BLOCKED
-        block->data.delay_count--;
+      if ((int) (block->data.wake_tick - current_tick) > 0) { // Still waiting
         return(BLOCKED);
       } else {
-        // last decrement, so zero out the block but keep blocking this time
         bzero((char *) block, sizeof(block_t));
         return(UNBLOCKED);
       } 
@@ -91,6 +85,10 @@ int check_block(block_t *block) {
     case TTY_WRITE_BLOCK :
       break;
 
+    // Woken by the disk trap once the request is done
+    case DISK_BLOCK :
+      return(BLOCKED);
+
     default :
       TracePrintf(3, "Referenced Block has unrecognized 'type' field\n");
       return(ERROR);
@@ -101,3 +99,15 @@ int check_block(block_t *block) {
   return ERROR; 
 
 }
+
+/*
+ * Function: wake_proc
+ *  @proc: a blocked process whose block has been satisfied
+ *
+ * Clears the process' block and puts it on the ready queue. Whatever
+ * queue the process was blocked on is the caller's to take it off of.
+ */
+void wake_proc(PCB_t *proc) {
+  bzero((char *) proc->block, sizeof(block_t));
+  make_ready(proc, SCHED_WAKE);
+}
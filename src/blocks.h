@@ -35,6 +35,7 @@
 #define PIPE_BLOCK        ((u_long) 0x3)
 #define TTY_READ_BLOCK    ((u_long) 0x4)
 #define TTY_WRITE_BLOCK   ((u_long) 0x5)
+#define DISK_BLOCK        ((u_long) 0x6)
 
 // Block Action constants
 #define UNBLOCKED         ((int) 0x0)
@@ -52,18 +53,22 @@ typedef struct block_t {
   u_long active;            // Is the block currently active?
   u_long type;              // What is the type of block?
   union {
-    int delay_count;        // The count of the delay for a delayed process
+    unsigned int wake_tick; // The clock tick a delayed process wakes on
     int ret_val;            // The value returned from the block if any
   } data;
   void *obj_ptr;            // A pointer to the relevant object for the block
-                            //  type. EG. for waiting, it's a List *
+                            //  type. EG. for waiting, it's a List *, and
+                            //  for a disk read, the buffer to fill
 
 } block_t;
 
 /*
  * Public Prototypes
  */
+struct PCB_t;
+
 int check_block(block_t *block);
+void wake_proc(struct PCB_t *proc);
 
 
 
@@ -1,9 +1,10 @@
 #ifndef _CVAR_H_
 #define _CVAR_H_
+#include "queue.h"
 
 typedef struct CVAR_t { 
   int id; 
-  List *waiters; 
+  proc_queue_t waiters;
 } CVAR_t;
 
 #endif 
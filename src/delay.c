@@ -0,0 +1,183 @@
+/*
+ * File: delay.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the delay queue declared in delay.h. Entries are
+ *    keyed by absolute wake tick, with a sequence number to break ties so
+ *    that the heap stays FIFO among processes waking on the same tick.
+ *    Tick comparisons are done on the signed difference, so the queue
+ *    keeps working when the tick counter wraps.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <stdlib.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "blocks.h"
+#include "delay.h"
+
+/*
+ * Private Types
+ */
+typedef struct delay_entry_t {
+  unsigned int wake_tick;   // Clock tick to wake up on
+  unsigned int seq;         // Order the delay was requested in
+  PCB_t *proc;              // The delayed process
+} delay_entry_t;
+
+/*
+ * Private Variables
+ */
+static delay_entry_t *delay_heap;   // Min-heap of delayed processes
+static int delay_len;               // Number of entries in the heap
+static int delay_cap;               // Number of entries the heap can hold
+static unsigned int delay_seq;      // Sequence number for the next entry
+
+#define DELAY_INITIAL_CAP   16
+
+/*
+ * Private Functions
+ */
+
+/*
+ * Function: delay_before
+ *
+ * Returns nonzero if entry a should wake before entry b.
+ */
+static int delay_before(delay_entry_t *a, delay_entry_t *b) {
+  int diff = (int) (a->wake_tick - b->wake_tick);
+
+  if (diff != 0)
+    return diff < 0;
+
+  return (int) (a->seq - b->seq) < 0;
+}
+
+/*
+ * Function: delay_swap
+ */
+static void delay_swap(int i, int j) {
+  delay_entry_t tmp = delay_heap[i];
+  delay_heap[i] = delay_heap[j];
+  delay_heap[j] = tmp;
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_delay_queue
+ *
+ * Returns SUCCESS, or ERROR if the heap couldn't be allocated.
+ */
+int init_delay_queue() {
+  delay_len = 0;
+  delay_seq = 0;
+  delay_cap = DELAY_INITIAL_CAP;
+  delay_heap = (delay_entry_t *) malloc(delay_cap * sizeof(delay_entry_t));
+
+  return (delay_heap == NULL) ? ERROR : SUCCESS;
+}
+
+/*
+ * Function: delay_enqueue
+ *  @proc: the process to delay (its block is set up here)
+ *  @ticks: number of clock ticks to wait, at least 1
+ *
+ * The process wakes on the ticks'th clock trap from now. The caller still
+ * has to switch away from it.
+ *
+ * Returns SUCCESS, or ERROR if the heap couldn't grow.
+ */
+int delay_enqueue(PCB_t *proc, int ticks) {
+  delay_entry_t *bigger;
+  int i;
+  int parent;
+
+  if (delay_len == delay_cap) {
+    bigger = (delay_entry_t *) realloc(delay_heap, 2 * delay_cap * sizeof(delay_entry_t));
+    if (bigger == NULL) {
+      TracePrintf(3, "delay_enqueue: no room to delay process %d\n", proc->proc_id);
+      return ERROR;
+    }
+    delay_heap = bigger;
+    delay_cap *= 2;
+  }
+
+  proc->block->active = BLOCK_ACTIVE;
+  proc->block->type = DELAY_BLOCK;
+  proc->block->data.wake_tick = current_tick + ticks;
+
+  // Sift the new entry up into place
+  i = delay_len++;
+  delay_heap[i].wake_tick = proc->block->data.wake_tick;
+  delay_heap[i].seq = delay_seq++;
+  delay_heap[i].proc = proc;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (!delay_before(delay_heap + i, delay_heap + parent))
+      break;
+    delay_swap(i, parent);
+    i = parent;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: delay_expire
+ *  @now: the current clock tick
+ *
+ * Moves every process whose wake tick has come to the ready queue.
+ *
+ * Returns the number of processes woken.
+ */
+int delay_expire(unsigned int now) {
+  PCB_t *proc;
+  int woken = 0;
+  int i;
+  int child;
+
+  while (delay_len > 0 && (int) (delay_heap[0].wake_tick - now) <= 0) {
+    proc = delay_heap[0].proc;
+
+    // Move the last entry to the top and sift it down
+    delay_heap[0] = delay_heap[--delay_len];
+    i = 0;
+    while ((child = 2 * i + 1) < delay_len) {
+      if (child + 1 < delay_len && delay_before(delay_heap + child + 1, delay_heap + child))
+        child++;
+      if (!delay_before(delay_heap + child, delay_heap + i))
+        break;
+      delay_swap(i, child);
+      i = child;
+    }
+
+    wake_proc(proc);
+    woken++;
+  }
+
+  return woken;
+}
+
+/*
+ * Function: delay_count
+ *
+ * Returns the number of processes blocked in Delay.
+ */
+int delay_count() {
+  return delay_len;
+}
@@ -0,0 +1,36 @@
+/*
+ * File:  delay.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The delay queue: processes blocked in Delay, kept in a binary
+ *    min-heap ordered by the clock tick they wake up on. The clock trap
+ *    only looks at the top of the heap, so its cost depends on how many
+ *    processes wake up that tick rather than on how many are delayed.
+ *
+ * Contents:
+ *    init_delay_queue()  - Allocate the heap
+ *    delay_enqueue()     - Block a process until a number of ticks pass
+ *    delay_expire()      - Wake every process whose delay is up
+ *    delay_count()       - Number of processes currently delayed
+ *
+ * Warnings:
+ *    Processes that wake on the same tick are woken in the order they
+ *    called Delay.
+ */
+
+#ifndef _DELAY_H_
+#define _DELAY_H_
+
+/*
+ * Public Prototypes
+ */
+struct PCB_t;
+
+int init_delay_queue();
+int delay_enqueue(struct PCB_t *proc, int ticks);
+int delay_expire(unsigned int now);
+int delay_count();
+
+#endif // _DELAY_H_
@@ -0,0 +1,220 @@
+/*
+ * File: disk.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the disk driver declared in disk.h. Waiting
+ *    requests are a singly linked list sorted by sector; requests for the
+ *    same sector stay in the order they were made. The request being
+ *    serviced is off the list, so nothing merges into it while the
+ *    hardware is using its data.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "disk.h"
+#include "slab.h"
+
+/*
+ * Private Types
+ */
+typedef struct disk_req_t {
+  int op;                     // DISK_READ or DISK_WRITE
+  int sector;
+  char data[SECTORSIZE];      // Read into here, or written from here
+  proc_queue_t waiters;       // Processes blocked until this is done
+  struct disk_req_t *next;    // Next waiting request, by sector
+} disk_req_t;
+
+/*
+ * Private Variables
+ */
+static disk_req_t *disk_queue;    // Waiting requests, sorted by sector
+static disk_req_t *disk_current;  // Request the disk is working on, or NULL
+static int disk_head;             // Last sector accessed
+static slab_cache_t disk_req_cache = SLAB_CACHE("disk_req", sizeof(disk_req_t));
+
+/*
+ * Private Function Definitions
+ */
+
+/*
+ * Function: disk_start
+ *
+ * Takes the next request in C-LOOK order off the queue and starts it.
+ */
+static void disk_start() {
+  disk_req_t **link;
+  disk_req_t *req;
+
+  // First request past the head; if there isn't one, wrap to the lowest
+  for (link = &disk_queue; *link != NULL; link = &(*link)->next) {
+    if ((*link)->sector > disk_head)
+      break;
+  }
+  if (*link == NULL)
+    link = &disk_queue;
+
+  req = *link;
+  *link = req->next;
+  req->next = NULL;
+
+  kstats.disk_seek += (req->sector > disk_head) ?
+      req->sector - disk_head : disk_head - req->sector;
+  if (req->op == DISK_READ)
+    kstats.disk_reads++;
+  else
+    kstats.disk_writes++;
+
+  disk_current = req;
+  disk_head = req->sector;
+  DiskAccess(req->op, req->sector, req->data);
+}
+
+/*
+ * Function: disk_copy_out
+ *  @proc: a process blocked on a read
+ *  @dest: its buffer, in region 1 or the kernel
+ *  @src: the sector's data
+ *
+ * Returns SUCCESS, or ERROR if @dest couldn't be written.
+ */
+static int disk_copy_out(PCB_t *proc, void *dest, char *src) {
+  if ((unsigned int) dest >= VMEM_1_BASE)
+    return copy_to_proc(proc, dest, src, SECTORSIZE);
+
+  memcpy(dest, src, SECTORSIZE);
+  return SUCCESS;
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_disk
+ */
+void init_disk() {
+  disk_queue = NULL;
+  disk_current = NULL;
+  disk_head = -1;
+}
+
+/*
+ * Function: disk_io
+ *  @op: DISK_READ or DISK_WRITE
+ *  @sector: the sector to access
+ *  @buf: SECTORSIZE bytes, in the current process or the kernel
+ *
+ * Queues (or merges) the request and blocks until it's done.
+ *
+ * Returns SUCCESS, or ERROR for a bad request.
+ */
+int disk_io(int op, int sector, void *buf) {
+  disk_req_t **link;
+  disk_req_t *last;
+  disk_req_t *req;
+  int result;
+
+  if ((op != DISK_READ && op != DISK_WRITE) || sector < 0 || sector >= NUMSECTORS) {
+    TracePrintf(1, "disk_io: bad request %d for sector %d\n", op, sector);
+    return ERROR;
+  }
+
+  // Find where this sector's requests end; last is the latest of them
+  last = NULL;
+  for (link = &disk_queue; *link != NULL && (*link)->sector <= sector; link = &(*link)->next) {
+    if ((*link)->sector == sector)
+      last = *link;
+  }
+
+  if (last != NULL && last->op == DISK_WRITE) {
+    kstats.disk_merged++;
+
+    // The disk will hold last's data by the time anything else happens
+    if (op == DISK_READ) {
+      memcpy(buf, last->data, SECTORSIZE);
+      return SUCCESS;
+    }
+
+    memcpy(last->data, buf, SECTORSIZE);
+    req = last;
+  } else if (last != NULL && op == DISK_READ) {
+    kstats.disk_merged++;
+    req = last;
+  } else {
+    req = (disk_req_t *) slab_alloc(&disk_req_cache);
+    if (req == NULL) {
+      TracePrintf(1, "disk_io: out of memory for a request\n");
+      return ERROR;
+    }
+
+    req->op = op;
+    req->sector = sector;
+    if (op == DISK_WRITE)
+      memcpy(req->data, buf, SECTORSIZE);
+    init_queue(&req->waiters);
+
+    req->next = *link;
+    *link = req;
+  }
+
+  bzero((char *) curr_proc->block, sizeof(block_t));
+  curr_proc->block->active = BLOCK_ACTIVE;
+  curr_proc->block->type = DISK_BLOCK;
+  curr_proc->block->obj_ptr = (op == DISK_READ) ? buf : NULL;
+  enqueue(&req->waiters, curr_proc);
+
+  if (disk_current == NULL)
+    disk_start();
+
+  switch_to_next_available_proc(curr_proc->uc, 0);
+
+  // disk_interrupt() left the result in our block
+  result = curr_proc->block->data.ret_val;
+  bzero((char *) curr_proc->block, sizeof(block_t));
+  return result;
+}
+
+/*
+ * Function: disk_interrupt
+ *
+ * Called from the disk trap. Hands the finished request's data to the
+ * processes waiting for it, wakes them, and starts the next request.
+ */
+void disk_interrupt() {
+  disk_req_t *req = disk_current;
+  PCB_t *waiter;
+
+  if (req == NULL) {
+    TracePrintf(3, "disk_interrupt: no request in progress\n");
+    return;
+  }
+  disk_current = NULL;
+
+  while ((waiter = dequeue(&req->waiters)) != NULL) {
+    waiter->block->data.ret_val = SUCCESS;
+    if (waiter->block->obj_ptr != NULL &&
+        disk_copy_out(waiter, waiter->block->obj_ptr, req->data) != SUCCESS)
+      waiter->block->data.ret_val = ERROR;
+
+    make_ready(waiter, SCHED_WAKE_IO);
+  }
+  slab_free(&disk_req_cache, req);
+
+  if (disk_queue != NULL)
+    disk_start();
+}
@@ -0,0 +1,39 @@
+/*
+ * File:  disk.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The disk driver. The hardware does one DiskAccess at a time, so
+ *    requests wait on a queue kept in sector order and are started in
+ *    C-LOOK order: up the disk from the last sector accessed, then back
+ *    to the lowest waiting sector. The process that asked for a sector
+ *    is blocked (DISK_BLOCK) on its request until the disk trap
+ *    completes it.
+ *
+ *    Requests for a sector that's already waiting are merged: a read
+ *    joins a waiting read, a write replaces the data of a waiting write,
+ *    and a read of a sector with a write waiting is answered from that
+ *    write's data without touching the disk.
+ *
+ * Contents:
+ *    init_disk()         - Set up the request queue
+ *    disk_io()           - Read or write one sector, blocking until done
+ *    disk_interrupt()    - Complete the request the disk just finished
+ *
+ * Warnings:
+ *    disk_io() blocks the current process, so it can only be called on
+ *    behalf of a process making a syscall.
+ */
+
+#ifndef _DISK_H_
+#define _DISK_H_
+
+/*
+ * Public Prototypes
+ */
+void init_disk();
+int disk_io(int op, int sector, void *buf);
+void disk_interrupt();
+
+#endif // _DISK_H_
@@ -0,0 +1,182 @@
+/*
+ * File: frames.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the physical frame allocator declared in frames.h.
+ *    The free frames live in an array used as a stack: frame_top is both
+ *    the index of the next free slot and the count of free frames.
+ *    Every allocated frame has a reference count so that copy-on-write
+ *    pages can be shared between processes; a frame only goes back on
+ *    the stack when its last reference is dropped.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *    Freeing a frame that is already free is caught (and traced) using
+ *    the reference counts, so a double free can't corrupt the stack.
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+#include <stdlib.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "frames.h"
+
+/*
+ * Private Variables
+ */
+static int *frame_stack;          // Stack of free frame numbers
+static int frame_top;             // Number of frames on the stack
+static unsigned short *frame_refs; // References to each frame (0 if free)
+static int frame_base;            // Lowest frame number managed here
+static int frame_count;           // Number of frames managed here
+
+static struct pte scratch_old;    // Mapping of the scratch page before use
+
+/*
+ * Function: init_frames
+ *  @first_fnum: lowest physical frame number available to the allocator
+ *  @last_fnum: one past the highest physical frame number available
+ *
+ * Returns SUCCESS, or ERROR if the bookkeeping couldn't be allocated.
+ */
+int init_frames(int first_fnum, int last_fnum) {
+  int i;
+
+  frame_base = first_fnum;
+  frame_count = last_fnum - first_fnum;
+  frame_top = 0;
+
+  frame_stack = (int *) malloc(frame_count * sizeof(int));
+  frame_refs = (unsigned short *) malloc(frame_count * sizeof(unsigned short));
+  if (frame_stack == NULL || frame_refs == NULL) {
+    TracePrintf(0, "init_frames: failed to allocate frame bookkeeping\n");
+    return ERROR;
+  }
+
+  // Push frames highest first so the lowest frames are handed out first
+  for (i = last_fnum - 1; i >= first_fnum; i--) {
+    frame_stack[frame_top++] = i;
+    frame_refs[i - frame_base] = 0;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: alloc_frame
+ *
+ * Returns the number of a free physical frame, or ERROR if none are left.
+ */
+int alloc_frame() {
+  int fnum;
+
+  if (frame_top <= 0)
+    return ERROR;
+
+  fnum = frame_stack[--frame_top];
+  frame_refs[fnum - frame_base] = 1;
+  kstats.frames_allocated++;
+  return fnum;
+}
+
+/*
+ * Function: ref_frame
+ *  @fnum: an allocated frame that is about to be mapped by one more page
+ */
+void ref_frame(int fnum) {
+  if (fnum < frame_base || fnum >= frame_base + frame_count) {
+    TracePrintf(3, "ref_frame: frame %d is not managed by the allocator\n", fnum);
+    return;
+  }
+
+  if (frame_refs[fnum - frame_base] == 0) {
+    TracePrintf(3, "ref_frame: frame %d is not allocated\n", fnum);
+    return;
+  }
+
+  frame_refs[fnum - frame_base]++;
+}
+
+/*
+ * Function: free_frame
+ *  @fnum: the physical frame number to release
+ *
+ * Drops one reference to the frame and returns it to the allocator once
+ * nobody maps it any more.
+ */
+void free_frame(int fnum) {
+  if (fnum < frame_base || fnum >= frame_base + frame_count) {
+    TracePrintf(3, "free_frame: frame %d is not managed by the allocator\n", fnum);
+    return;
+  }
+
+  if (frame_refs[fnum - frame_base] == 0) {
+    TracePrintf(3, "free_frame: frame %d freed twice\n", fnum);
+    return;
+  }
+
+  if (--frame_refs[fnum - frame_base] == 0) {
+    frame_stack[frame_top++] = fnum;
+    kstats.frames_freed++;
+  }
+}
+
+/*
+ * Function: frame_refcount
+ *  @fnum: the physical frame number to check
+ *
+ * Returns the number of pages currently mapping the frame.
+ */
+int frame_refcount(int fnum) {
+  if (fnum < frame_base || fnum >= frame_base + frame_count)
+    return 0;
+
+  return frame_refs[fnum - frame_base];
+}
+
+/*
+ * Function: frames_available
+ *
+ * Returns the number of physical frames that can currently be allocated.
+ */
+int frames_available() {
+  return frame_top;
+}
+
+/*
+ * Function: map_scratch_frame
+ *  @fnum: the physical frame to make addressable
+ *
+ * Maps the frame at the page directly beneath the kernel stack so the
+ * kernel can read or write it regardless of which process owns it.
+ * Only one frame can be mapped at a time.
+ *
+ * Returns the virtual address the frame is mapped at.
+ */
+void *map_scratch_frame(int fnum) {
+  scratch_old = r0_pagetable[SCRATCH_PAGE];
+
+  r0_pagetable[SCRATCH_PAGE].valid = (u_long) 0x1;
+  r0_pagetable[SCRATCH_PAGE].prot = (u_long) (PROT_READ | PROT_WRITE);
+  r0_pagetable[SCRATCH_PAGE].pfn = FNUM_TO_PFN(fnum);
+  tlb_flush_page((void *) (SCRATCH_PAGE << PAGESHIFT));
+
+  return (void *) (SCRATCH_PAGE << PAGESHIFT);
+}
+
+/*
+ * Function: unmap_scratch_frame
+ *
+ * Restores whatever was mapped at the scratch page before
+ * map_scratch_frame was called.
+ */
+void unmap_scratch_frame() {
+  r0_pagetable[SCRATCH_PAGE] = scratch_old;
+  tlb_flush_page((void *) (SCRATCH_PAGE << PAGESHIFT));
+}
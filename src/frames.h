@@ -0,0 +1,54 @@
+/*
+ * File:  frames.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The physical frame allocator. Free frames are kept on a fixed-size
+ *    stack of frame numbers that is allocated once at boot, so allocating,
+ *    freeing, and counting free frames are all O(1) and never touch the
+ *    kernel heap.
+ *
+ * Contents:
+ *    init_frames()       - Build the free stack over a range of frames
+ *    alloc_frame()       - Take a frame off the free stack (refcount 1)
+ *    ref_frame()         - Add a reference to a frame shared by processes
+ *    free_frame()        - Drop a reference; return the frame at zero
+ *    frame_refcount()    - Number of references to a frame
+ *    frames_available()  - Number of frames currently free
+ *    map_scratch_frame() - Map a frame at the scratch page in region 0
+ *    unmap_scratch_frame() - Restore the scratch page's old mapping
+ *
+ * Warnings:
+ *    init_frames() mallocs its stack, so it must be called from KernelStart
+ *    before the page tables for the kernel heap are built.
+ */
+
+#ifndef _FRAMES_H_
+#define _FRAMES_H_
+
+/*
+ * System includes
+ */
+#include <hardware.h>
+
+/*
+ * Public Constant Definitions
+ */
+// Scratch page just below the kernel stack, used to reach arbitrary frames
+#define SCRATCH_PAGE  ((KERNEL_STACK_BASE >> PAGESHIFT) - 1)
+
+/*
+ * Public Prototypes
+ */
+int init_frames(int first_fnum, int last_fnum);
+int alloc_frame();
+void ref_frame(int fnum);
+void free_frame(int fnum);
+int frame_refcount(int fnum);
+int frames_available();
+
+void *map_scratch_frame(int fnum);
+void unmap_scratch_frame();
+
+#endif // _FRAMES_H_
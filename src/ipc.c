@@ -0,0 +1,378 @@
+/*
+ * File: ipc.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the message passing syscalls described in ipc.h.
+ *    Each process has a FIFO queue of the senders waiting for it to
+ *    Receive (ipc_senders); a sender that has been received is on no
+ *    queue, and is found through its ipc_peer instead.
+ *
+ * To Do:
+ *    - Receive could fail instead of blocking when every other process
+ *      is blocked too
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "syscalls.h"
+#include "ipc.h"
+
+/*
+ * Private Variables
+ */
+static int ipc_servers[MAX_SERVER_INDEX + 1];   // pid registered at each index
+
+/*
+ * Private Function Definitions
+ */
+
+/*
+ * Function: ipc_find
+ *  @pid: a process id
+ *
+ * Returns the live process with that id, or NULL.
+ */
+static PCB_t *ipc_find(int pid) {
+  ListNode *node = find_by_id(all_procs, pid);
+
+  return (node == NULL) ? NULL : (PCB_t *) node->data;
+}
+
+/*
+ * Function: ipc_target
+ *  @pid: a process id, or minus a server index
+ *
+ * Returns the process a message to @pid goes to, or NULL if there's no
+ * such process (or it's the current one).
+ */
+static PCB_t *ipc_target(int pid) {
+  PCB_t *proc;
+
+  if (pid < 0) {
+    if (-pid > MAX_SERVER_INDEX || ipc_servers[-pid] < 0)
+      return NULL;
+    pid = ipc_servers[-pid];
+  }
+
+  proc = ipc_find(pid);
+  if (proc == curr_proc)
+    return NULL;
+
+  return proc;
+}
+
+/*
+ * Function: ipc_client
+ *  @pid: a process id
+ *
+ * Returns the process if it's waiting for the current process to reply
+ * to it, or NULL.
+ */
+static PCB_t *ipc_client(int pid) {
+  PCB_t *proc = ipc_find(pid);
+
+  if (proc == NULL || proc->ipc_state != IPC_REPLY_WAIT ||
+      proc->ipc_peer != (int) curr_proc->proc_id)
+    return NULL;
+
+  return proc;
+}
+
+/*
+ * Function: ipc_wake
+ *  @proc: a process blocked in Send or Receive
+ *  @result: what its syscall returns
+ */
+static void ipc_wake(PCB_t *proc, int result) {
+  proc->ipc_state = IPC_NONE;
+  proc->ipc_result = result;
+  make_ready(proc, SCHED_WAKE);
+}
+
+/*
+ * Function: ipc_post
+ *  @sender: the process the message is from
+ *  @dest: the process it's to
+ *  @msg: the message, at an address in the current process
+ *
+ * Delivers the message straight into @dest's buffer if @dest is waiting
+ * to receive it, and otherwise queues @sender on @dest. Either way
+ * @sender is left waiting and has to be blocked by the caller if it's
+ * the current process.
+ *
+ * Returns SUCCESS, or ERROR if @dest's buffer couldn't be written.
+ */
+static int ipc_post(PCB_t *sender, PCB_t *dest, void *msg) {
+  sender->ipc_peer = dest->proc_id;
+
+  if (dest->ipc_state == IPC_RECV_WAIT &&
+      (dest->ipc_peer == IPC_ANY || dest->ipc_peer == (int) sender->proc_id)) {
+    if (copy_to_proc(dest, dest->ipc_buf, msg, MESSAGE_SIZE) != SUCCESS)
+      return ERROR;
+
+    sender->ipc_state = IPC_REPLY_WAIT;
+    ipc_wake(dest, sender->proc_id);
+    return SUCCESS;
+  }
+
+  sender->ipc_state = IPC_SEND_WAIT;
+  enqueue(&dest->ipc_senders, sender);
+  return SUCCESS;
+}
+
+/*
+ * Function: ipc_receive
+ *  @msg: where to put the message
+ *  @pid: the process to receive from, or IPC_ANY
+ *
+ * Returns the pid of the sender, or ERROR.
+ */
+static int ipc_receive(void *msg, int pid) {
+  PCB_t *sender;
+
+  // Oldest queued sender we'll take
+  sender = queue_head(&curr_proc->ipc_senders);
+  if (pid != IPC_ANY) {
+    while (sender != NULL && (int) sender->proc_id != pid)
+      sender = sender->q_next;
+  }
+
+  if (sender == NULL) {
+    curr_proc->ipc_state = IPC_RECV_WAIT;
+    curr_proc->ipc_peer = pid;
+    curr_proc->ipc_buf = msg;
+    switch_to_next_available_proc(curr_proc->uc, 0);
+
+    // A sender delivered its message and set ipc_result to its pid
+    return curr_proc->ipc_result;
+  }
+
+  dequeue_proc(sender);
+  if (copy_from_proc(sender, msg, sender->ipc_buf, MESSAGE_SIZE) != SUCCESS) {
+    ipc_wake(sender, ERROR);
+    return ERROR;
+  }
+
+  sender->ipc_state = IPC_REPLY_WAIT;
+  return sender->proc_id;
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_ipc
+ */
+void init_ipc() {
+  int i;
+
+  for (i = 0; i <= MAX_SERVER_INDEX; i++)
+    ipc_servers[i] = -1;
+}
+
+/*
+ * Function: ipc_exit
+ *  @proc: the process that's exiting
+ *
+ * Drops @proc's server registrations and fails the Send or Receive of
+ * every process waiting on it.
+ */
+void ipc_exit(PCB_t *proc) {
+  PCB_t *waiter;
+  ListNode *node;
+  int i;
+
+  for (i = 0; i <= MAX_SERVER_INDEX; i++) {
+    if (ipc_servers[i] == (int) proc->proc_id)
+      ipc_servers[i] = -1;
+  }
+
+  while ((waiter = dequeue(&proc->ipc_senders)) != NULL)
+    ipc_wake(waiter, ERROR);
+
+  // Senders it received but didn't reply to, and ReceiveSpecifics on it
+  for (node = all_procs->first; node != NULL; node = node->next) {
+    waiter = (PCB_t *) node->data;
+    if ((waiter->ipc_state == IPC_REPLY_WAIT || waiter->ipc_state == IPC_RECV_WAIT) &&
+        waiter->ipc_peer == (int) proc->proc_id)
+      ipc_wake(waiter, ERROR);
+  }
+}
+
+/*
+ * Function: Yalnix_Register
+ *  @index: server index, 1 through MAX_SERVER_INDEX
+ *
+ * Makes the current process the server that Send(msg, -index) goes to.
+ */
+int Yalnix_Register(unsigned int index) {
+  if (index < 1 || index > MAX_SERVER_INDEX) {
+    TracePrintf(1, "Register: bad server index %u\n", index);
+    return ERROR;
+  }
+
+  if (ipc_servers[index] >= 0 && ipc_servers[index] != (int) curr_proc->proc_id) {
+    TracePrintf(1, "Register: index %u is taken by %d\n", index, ipc_servers[index]);
+    return ERROR;
+  }
+
+  ipc_servers[index] = curr_proc->proc_id;
+  return SUCCESS;
+}
+
+/*
+ * Function: Yalnix_Send
+ *  @msg: MESSAGE_SIZE bytes to send, overwritten with the reply
+ *  @pid: the process to send to, or minus a server index
+ *
+ * Returns 0 once the message is replied to, or ERROR.
+ */
+int Yalnix_Send(void *msg, int pid) {
+  PCB_t *dest = ipc_target(pid);
+
+  if (dest == NULL) {
+    TracePrintf(1, "Send: no process %d\n", pid);
+    return ERROR;
+  }
+
+  curr_proc->ipc_buf = msg;
+  if (ipc_post(curr_proc, dest, msg) != SUCCESS)
+    return ERROR;
+
+  switch_to_next_available_proc(curr_proc->uc, 0);
+
+  // Set by Reply, or to ERROR if the receiver went away
+  return curr_proc->ipc_result;
+}
+
+/*
+ * Function: Yalnix_Receive
+ *  @msg: where to put the MESSAGE_SIZE byte message
+ *
+ * Returns the pid of the sender, or ERROR.
+ */
+int Yalnix_Receive(void *msg) {
+  return ipc_receive(msg, IPC_ANY);
+}
+
+/*
+ * Function: Yalnix_ReceiveSpecific
+ *  @msg: where to put the MESSAGE_SIZE byte message
+ *  @pid: the only process to take a message from
+ *
+ * Returns @pid, or ERROR.
+ */
+int Yalnix_ReceiveSpecific(void *msg, int pid) {
+  if (pid < 0 || ipc_target(pid) == NULL) {
+    TracePrintf(1, "ReceiveSpecific: no process %d\n", pid);
+    return ERROR;
+  }
+
+  return ipc_receive(msg, pid);
+}
+
+/*
+ * Function: Yalnix_Reply
+ *  @msg: MESSAGE_SIZE bytes to copy over the sender's message
+ *  @pid: a sender the current process received from
+ *
+ * Returns 0, or ERROR if @pid isn't waiting for a reply from us.
+ */
+int Yalnix_Reply(void *msg, int pid) {
+  PCB_t *client = ipc_client(pid);
+
+  if (client == NULL) {
+    TracePrintf(1, "Reply: %d isn't waiting for a reply\n", pid);
+    return ERROR;
+  }
+
+  if (copy_to_proc(client, client->ipc_buf, msg, MESSAGE_SIZE) != SUCCESS) {
+    ipc_wake(client, ERROR);
+    return ERROR;
+  }
+
+  ipc_wake(client, 0);
+  return SUCCESS;
+}
+
+/*
+ * Function: Yalnix_Forward
+ *  @msg: MESSAGE_SIZE bytes to send in place of the original message
+ *  @pid: the process to forward to, or minus a server index
+ *  @src_pid: a sender the current process received from
+ *
+ * Sends @msg to @pid as though @src_pid had sent it, so the reply goes
+ * to @src_pid. If it can't be delivered, @src_pid's Send fails instead.
+ *
+ * Returns 0, or ERROR if @src_pid isn't waiting for a reply from us.
+ */
+int Yalnix_Forward(void *msg, int pid, int src_pid) {
+  PCB_t *client = ipc_client(src_pid);
+  PCB_t *dest = ipc_target(pid);
+
+  if (client == NULL) {
+    TracePrintf(1, "Forward: %d isn't waiting for a reply\n", src_pid);
+    return ERROR;
+  }
+
+  // The new message replaces the old one in the sender's buffer, which
+  // is where a receiver that isn't waiting yet will pick it up
+  if (dest == NULL || dest == client ||
+      copy_to_proc(client, client->ipc_buf, msg, MESSAGE_SIZE) != SUCCESS ||
+      ipc_post(client, dest, msg) != SUCCESS) {
+    ipc_wake(client, ERROR);
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: Yalnix_CopyFrom
+ *  @src_pid: a sender the current process received from
+ *  @dest: buffer in the current process
+ *  @src: buffer in @src_pid
+ *  @len: number of bytes
+ *
+ * Returns 0, or ERROR.
+ */
+int Yalnix_CopyFrom(int src_pid, void *dest, void *src, int len) {
+  PCB_t *client = ipc_client(src_pid);
+
+  if (client == NULL || len < 0) {
+    TracePrintf(1, "CopyFrom: %d isn't waiting for a reply\n", src_pid);
+    return ERROR;
+  }
+
+  return copy_from_proc(client, dest, src, len);
+}
+
+/*
+ * Function: Yalnix_CopyTo
+ *  @dest_pid: a sender the current process received from
+ *  @dest: buffer in @dest_pid
+ *  @src: buffer in the current process
+ *  @len: number of bytes
+ *
+ * Returns 0, or ERROR.
+ */
+int Yalnix_CopyTo(int dest_pid, void *dest, void *src, int len) {
+  PCB_t *client = ipc_client(dest_pid);
+
+  if (client == NULL || len < 0) {
+    TracePrintf(1, "CopyTo: %d isn't waiting for a reply\n", dest_pid);
+    return ERROR;
+  }
+
+  return copy_to_proc(client, dest, src, len);
+}
@@ -0,0 +1,54 @@
+/*
+ * File:  ipc.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Synchronous message passing: Register, Send, Receive,
+ *    ReceiveSpecific, Reply, Forward, CopyFrom, and CopyTo. Messages are
+ *    MESSAGE_SIZE bytes. A sender blocks until its message is replied to,
+ *    and the reply overwrites the message in its buffer. While it waits
+ *    for the reply, the process that received it can CopyFrom/CopyTo the
+ *    sender's memory.
+ *
+ *    Every copy goes straight between the two address spaces (through
+ *    copy_to_proc() and copy_from_proc()); nothing is staged in the
+ *    kernel heap. A message is copied once, either when the sender finds
+ *    its receiver already waiting or when the receiver takes it off its
+ *    queue of senders.
+ *
+ * Contents:
+ *    IPC_*               - States a process can be in for message passing
+ *    init_ipc()          - Clear the server registrations
+ *    ipc_exit()          - Fail everything waiting on an exiting process
+ *
+ * Warnings:
+ *    The pages CopyFrom reads from the sender have to be loaded, and the
+ *    pages CopyTo writes have to be loaded and not shared copy-on-write;
+ *    otherwise the call fails. The sender can guarantee this by writing
+ *    to its buffers before it sends.
+ */
+
+#ifndef _IPC_H_
+#define _IPC_H_
+
+/*
+ * Public Constant Definitions
+ */
+// PCB ipc_state values
+#define IPC_NONE          0     // Not sending or receiving
+#define IPC_SEND_WAIT     1     // Queued on ipc_peer's senders
+#define IPC_REPLY_WAIT    2     // Received by ipc_peer, waiting for a reply
+#define IPC_RECV_WAIT     3     // Blocked in Receive (from ipc_peer, if set)
+
+#define IPC_ANY           (-1)  // ipc_peer of a Receive that takes anyone
+
+/*
+ * Public Prototypes
+ */
+struct PCB_t;
+
+void init_ipc();
+void ipc_exit(struct PCB_t *proc);
+
+#endif // _IPC_H_
@@ -7,6 +7,9 @@
 #include "traps.h"
 #include "tty.h"
 #include "PCB.h"
+#include "pipe.h"
+#include <string.h>
+#include <stdlib.h>
 
 
 // Statically declared interrupt_vector
@@ -70,8 +73,8 @@ void KernelStart(char *cmd_args[],
   int idle_stack_fnum2;                 // Number of idle's 2nd stack frame
 
   int lp_rc;                            // Return code of load program
+  tlb_batch_t batch;                    // Pages whose mappings changed
   int arg_count;                        // The number of arguments passed into cmd_args
-  ListNode *node;                       // Reusable node declaration
   /*
    * =========================================
    *    Initialize Global Kernel Variables,
@@ -84,47 +87,76 @@ void KernelStart(char *cmd_args[],
   kernel_brk = kernel_data_end;         // break starts as kernel_data_end
   available_process_id = 0;             // PIDs start at 0
   vm_en = 0;                            // VM is initially disabled
+  lazy_load = 1;                        // Demand-page programs by default
+  sched_policy = "rr";                  // Round robin...
+  sched_quantum = 1;                    // ...switching every tick by default
+  pipe_capacity = MAX_PIPE_LEN;
+  tty_out_capacity = TTY_OUT_LEN;
+  bcache_frames = BCACHE_DEFAULT_FRAMES;
+  bzero((char *) &kstats, sizeof(kstats_t));
+
+  // Strip off the kernel's own options, leaving the init program and its args
+  cmd_args = cmd_args + parse_kernel_args(cmd_args);
 
   // Physical Frame-related variables
   total_pframes = pmem_size / PAGESIZE;
   pframes_in_kernel = (VMEM_0_LIMIT >> PAGESHIFT);
-  pframes_in_use = UP_TO_PAGE(kernel_brk) >> PAGESHIFT;     // Is this necessary forever?
   
   base_frame_r1 = DOWN_TO_PAGE(VMEM_1_BASE) >> PAGESHIFT;
   top_frame_r1 = UP_TO_PAGE(VMEM_1_LIMIT) >> PAGESHIFT;
 
   // Allocate kernel heap space for the Kernel's Process Queues
-  ready_procs = (List *)init_list();
-  blocked_procs = (List *)init_list();
+  if (sched_init(sched_policy, sched_quantum) != SUCCESS) {
+    TracePrintf(0, "KernelStart: unknown scheduler '%s'\n", sched_policy);
+    Halt();
+  }
   all_procs = (List *)init_list(); 
   dead_procs = (List *)init_list(); 
 
+  current_tick = 0;
+  if (init_delay_queue() != SUCCESS) {
+    TracePrintf(0, "KernelStart: failed to initialize the delay queue\n");
+    Halt();
+  }
+
   /*
    * =========================================
    *    Create additional data structs 
-   *    ( buffers, (todo: locks, cvars, pipes))
+   *    ( buffers, locks, cvars, pipes )
    * =========================================
    */
-  ttys = (List *)init_list();
-  for (i = 0; i < NUM_TERMINALS; i++) { 
-    TTY_t *tmp = (TTY_t *)malloc( sizeof(TTY_t) );
-    tmp->buffers = (List *)init_list();
-    tmp->writers = (List *)init_list();
-    tmp->readers = (List *)init_list();
-    tmp->id = i;
-    add_to_list(ttys, (void *)tmp, i); 
+  if (init_ttys() != SUCCESS) {
+    TracePrintf(0, "KernelStart: failed to create the terminals\n");
+    Halt();
+  }
+
+  // Locks, cvars, and pipes are all found through the resource table
+  if (init_resources() != SUCCESS) {
+    TracePrintf(0, "KernelStart: failed to initialize the resource table\n");
+    Halt();
+  }
+
+  // No message passing servers yet
+  init_ipc();
+
+  // Nothing waiting on the disk
+  init_disk();
+
+  // Create the pool of empty frames (every frame above region 0)
+  if (init_frames(pframes_in_kernel, total_pframes) != SUCCESS) {
+    TracePrintf(0, "KernelStart: failed to initialize the frame allocator\n");
+    Halt();
   }
 
-  next_resource_id = 0;
-  locks = (List *)init_list();
-  cvars = (List *)init_list();
-  pipes = (List *)init_list();
+  // Take the buffer cache's frames before anything else can
+  if (init_bcache(bcache_frames) != SUCCESS) {
+    TracePrintf(0, "KernelStart: failed to initialize the buffer cache\n");
+    Halt();
+  }
 
-// Create the list of empty frames
-    // NOTE: in FrameList, the number of the physical frame is
-    //      stored in the id field of the node, NOT data.
-  for (i = pframes_in_kernel; i < total_pframes; i++)
-      add_to_list(&FrameList, (void *) NULL, i);
+  // The kernel heap is in use up to the break, which now covers everything
+  // malloc'd above (including the frame allocator's bookkeeping)
+  pframes_in_use = UP_TO_PAGE(kernel_brk) >> PAGESHIFT;
 
 
   /*
@@ -168,6 +200,9 @@ void KernelStart(char *cmd_args[],
     r1_pagetable[i - base_frame_r1] = entry;
   }
 
+  // The buffer cache's window sits between the heap and the kernel stack
+  bcache_map();
+
 
   /*
    * =========================================
@@ -187,7 +222,7 @@ void KernelStart(char *cmd_args[],
 
   // Enable Virtual memory and flush the TLB
   WriteRegister(REG_VM_ENABLE, 1);
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  tlb_flush(TLB_FLUSH_ALL);
   vm_en = 1; 
   TracePrintf(1, "Virtual Memory Enabled!\n");
 
@@ -203,12 +238,8 @@ void KernelStart(char *cmd_args[],
 
   // Set up the user stack by allocating two frames
   // leaving the very top one empty (for the hardware)
-  node = pop(&FrameList);
-  idle_stack_fnum1 = node->id;
-  free(node);
-  node = pop(&FrameList);
-  idle_stack_fnum2 = node->id;
-  free(node);
+  idle_stack_fnum1 = alloc_frame();
+  idle_stack_fnum2 = alloc_frame();
 
   // Update the r1 page table with validity & pfn of idle's stack
   r1_pagetable[VMEM_1_PAGE_COUNT - 1].valid = (u_long) 0x1;
@@ -216,34 +247,34 @@ void KernelStart(char *cmd_args[],
   r1_pagetable[VMEM_1_PAGE_COUNT - 2].valid = (u_long) 0x1;
   r1_pagetable[VMEM_1_PAGE_COUNT - 2].pfn = (u_long) ((idle_stack_fnum2 * PAGESIZE) >> PAGESHIFT);
 
-  // flush the TLB region 1 since we changed r1_pagetable
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+  // flush the two pages of r1_pagetable we changed
+  tlb_batch_init(&batch);
+  tlb_batch_add(&batch, (void *) (VMEM_1_LIMIT - PAGESIZE));
+  tlb_batch_add(&batch, (void *) (VMEM_1_LIMIT - 2 * PAGESIZE));
+  tlb_batch_flush(&batch);
 
 
   // Manually assign values to the PCB structure and UserContext for idle
   idle_proc->uc->pc = &DoIdle;                                  // pc points to idle function
   idle_proc->uc->sp = (void *) (VMEM_1_LIMIT - PAGESIZE);       // Manually created stack
 
-  idle_proc->region1_pt = &r1_pagetable[0];
- 
-  // Allocate space for the KernelContext (in the idle proc)
-  idle_proc->kc_p = (KernelContext *)malloc( sizeof(KernelContext) );
+  // The KernelContext came with the PCB (see new_process())
   idle_proc->kc_set = 1;    // we'll set it on first clock trap no matter what
 
   // The idle process has no parent
   idle_proc->parent = NULL;
 
-  // Allocate idle's kernel stack page table
-  idle_proc->region0_pt = (struct pte *)malloc( KS_NPG * sizeof(struct pte));
+  // Allocate idle's kernel stack and region 1 page tables
+  if (alloc_page_tables(idle_proc) != SUCCESS) {
+    TracePrintf(3, "Failed to allocate the idle process' page tables\n");
+    Halt();
+  }
 
   // Copy idle's kernel stack page table
   memcpy((void *)idle_proc->region0_pt,
           (void *) &(r0_pagetable[KERNEL_STACK_BASE >> PAGESHIFT]), 
           KS_NPG * sizeof(struct pte));
 
-  // Allocate idle's region 1 page table
-  idle_proc->region1_pt = (struct pte *)malloc( VMEM_1_PAGE_COUNT * sizeof(struct pte));
-
   // Copy over idle's region 1 page table
   memcpy((void *)idle_proc->region1_pt, (void *) r1_pagetable, VMEM_1_PAGE_COUNT * sizeof(struct pte));
 
@@ -257,10 +288,11 @@ void KernelStart(char *cmd_args[],
   // Make a shell process based on idle_proc
   PCB_t *init_proc = new_process(idle_proc->uc);
 
-  // Allocate space for init's Kernel Stack and Region 1 ptes
-  init_proc->region0_pt = (struct pte *)malloc(KS_NPG  * sizeof(struct pte));
-  init_proc->region1_pt = (struct pte *)malloc(VMEM_1_PAGE_COUNT * sizeof(struct pte));
-  bzero((char *)(init_proc->region1_pt), VMEM_1_PAGE_COUNT * sizeof(struct pte));
+  // Allocate space for init's Kernel Stack and Region 1 ptes (zeroed)
+  if (alloc_page_tables(init_proc) != SUCCESS) {
+    TracePrintf(3, "Failed to allocate the init process' page tables\n");
+    Halt();
+  }
 
   // Initialize R1 memory to be invalid, with r/w protections, and no pfn 
   for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
@@ -273,13 +305,11 @@ void KernelStart(char *cmd_args[],
   for (i = 0; i < KS_NPG; i++) {
     (*(init_proc->region0_pt + i)).valid = (u_long) 0x1;
     (*(init_proc->region0_pt + i)).prot = (u_long) (PROT_READ | PROT_WRITE);
-    node = pop(&FrameList);
-    (*(init_proc->region0_pt + i)).pfn = (u_long) ((node->id * PAGESIZE) >> PAGESHIFT);  
-    free(node);
+    (*(init_proc->region0_pt + i)).pfn = FNUM_TO_PFN(alloc_frame());
   }
   
-  // Flush the TLB having updated pagetables
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  // init's page tables aren't loaded into the hardware yet, so nothing they
+  // map can be in the TLB and there's nothing to flush
   
   // init_proc is the first child of idle_proc!
   init_proc->parent = idle_proc;
@@ -308,11 +338,11 @@ void KernelStart(char *cmd_args[],
     if ((lp_rc = LoadProgram(progname, arglist, init_proc)) != SUCCESS) {
       // Restore old PTBR1 if we failed
       WriteRegister(REG_PTBR1, (unsigned int)&r1_pagetable);
-      WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+      tlb_flush(TLB_FLUSH_1);
       TracePrintf(3, "LoadProgram failed with code %d\n", lp_rc);
     } else { 
       add_to_list(all_procs, (void *)init_proc, init_proc->proc_id);      
-      add_to_list(ready_procs, (void *)init_proc, init_proc->proc_id);
+      make_ready(init_proc, SCHED_NEW);
     } 
     
     */
@@ -337,11 +367,11 @@ void KernelStart(char *cmd_args[],
     if ((lp_rc = LoadProgram(progname, arglist, init_proc)) != SUCCESS) {      
       // Restore old PTBR1 if we failed
       WriteRegister(REG_PTBR1, (unsigned int)&r1_pagetable);
-      WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+      tlb_flush(TLB_FLUSH_1);
       TracePrintf(3, "LoadProgram failed with code %d\n", lp_rc);
     } else { 
       add_to_list(all_procs, (void *)init_proc, init_proc->proc_id);      
-      add_to_list(ready_procs, (void *)init_proc, init_proc->proc_id);
+      make_ready(init_proc, SCHED_NEW);
     } 
 
   }
@@ -367,6 +397,50 @@ void KernelStart(char *cmd_args[],
 
 
 
+/*
+ * function: parse_kernel_args
+ *  @cmd_args: the argument list passed to KernelStart
+ *
+ * Kernel options come before the name of the init program and each starts
+ * with a '-'. Recognized options:
+ *    -eager      Load every page of a program in LoadProgram up front
+ *    -sched name Use the named scheduler ("rr" or "mlfq"; see sched.h)
+ *    -quantum n  Base scheduling quantum, in clock ticks
+ *    -pipesz n   Capacity of new pipes in bytes (rounded up to a power of two)
+ *    -bcache n   Frames to give the sector buffer cache (0 to turn it off)
+ *    -ttybuf n   Size of each terminal's output ring in bytes (rounded up
+ *                to a power of two)
+ *
+ * Returns the index in cmd_args of the first argument that isn't a kernel
+ * option (the name of the init program, if there is one).
+ */
+int parse_kernel_args(char *cmd_args[]) {
+  int i = 0;
+
+  while (cmd_args[i] != NULL && cmd_args[i][0] == '-') {
+    if (strcmp(cmd_args[i], "-eager") == 0) {
+      lazy_load = 0;
+    } else if (strcmp(cmd_args[i], "-sched") == 0 && cmd_args[i + 1] != NULL) {
+      sched_policy = cmd_args[++i];
+    } else if (strcmp(cmd_args[i], "-quantum") == 0 && cmd_args[i + 1] != NULL) {
+      sched_quantum = atoi(cmd_args[++i]);
+    } else if (strcmp(cmd_args[i], "-pipesz") == 0 && cmd_args[i + 1] != NULL) {
+      pipe_capacity = atoi(cmd_args[++i]);
+    } else if (strcmp(cmd_args[i], "-bcache") == 0 && cmd_args[i + 1] != NULL) {
+      bcache_frames = atoi(cmd_args[++i]);
+    } else if (strcmp(cmd_args[i], "-ttybuf") == 0 && cmd_args[i + 1] != NULL) {
+      tty_out_capacity = atoi(cmd_args[++i]);
+    } else {
+      TracePrintf(0, "KernelStart: ignoring unknown kernel option '%s'\n", cmd_args[i]);
+    }
+    i++;
+  }
+
+  return i;
+}
+
+
+
 /*
  * function: MyKCSClone
  *  @kc_in:         Pointer to the kernel context to clone
@@ -386,21 +460,26 @@ void *MyKCSClone(KernelContext *kc_in, void *curr_pcb_p, void *next_pcb_p) {
     u_long old_validity[KS_NPG];
     unsigned int dest;
     unsigned int src;
+    struct pte *pte;
+    tlb_batch_t batch;
+
+    tlb_batch_init(&batch);
 
     // Clone current kernel context into the next proc's kc pointer
     memcpy( (void *) (next->kc_p), (void *) (curr->kc_p), sizeof(KernelContext));
 
     // Temporarily map the kernel stack into frames in the current region 1
     for (i = 0; i < KS_NPG; i++) {
-        old_pfns[i] = r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].pfn;
-        old_validity[i] = r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].valid;
+        pte = &r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i];
+        old_pfns[i] = pte->pfn;
+        old_validity[i] = pte->valid;
 
-        r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].valid = (u_long) 0x1;
-        r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].pfn = ((*(next->region0_pt + i)).pfn);
+        tlb_set_pte(&batch, pte, (void *) (KERNEL_STACK_BASE - KERNEL_STACK_MAXSIZE + (i << PAGESHIFT)),
+            (u_long) 0x1, pte->prot, (*(next->region0_pt + i)).pfn);
     }
 
-    // Having changed the R0 pagetables, flush the TLB
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+    // Having changed the R0 pagetables, flush the pages we remapped
+    tlb_batch_flush(&batch);
 
     // Copy the contents of the current kernel stack into the new kernel stack
     dest = ((KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG) << PAGESHIFT;
@@ -409,12 +488,13 @@ void *MyKCSClone(KernelContext *kc_in, void *curr_pcb_p, void *next_pcb_p) {
 
     // Restore the old kernel page mappings
     for (i = 0; i < KS_NPG; i++) {
-        r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].pfn = old_pfns[i];
-        r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i].valid = old_validity[i];
+        pte = &r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) - KS_NPG + i];
+        tlb_set_pte(&batch, pte, (void *) (KERNEL_STACK_BASE - KERNEL_STACK_MAXSIZE + (i << PAGESHIFT)),
+            old_validity[i], pte->prot, old_pfns[i]);
     }
 
-    // Having changed the R0 pagetables, flush the tlb again
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+    // Having changed the R0 pagetables, flush them again
+    tlb_batch_flush(&batch);
 
     TracePrintf(1, "End: MyKCSClone \n");
     return next->kc_p;
@@ -435,6 +515,7 @@ KernelContext *MyKCSSwitch(KernelContext *kc_in, void *curr_pcb_p, void *next_pc
     int i, j;
     PCB_t *curr = (PCB_t *) curr_pcb_p;
     PCB_t *next = (PCB_t *) next_pcb_p;
+    tlb_batch_t batch;
 
     // Save the current process' kernel context
     if (curr != NULL)
@@ -456,19 +537,22 @@ KernelContext *MyKCSSwitch(KernelContext *kc_in, void *curr_pcb_p, void *next_pc
               KS_NPG * (sizeof(struct pte)));
     }
 
-    // Restore the next region's kernel stack
-    memcpy((void *) (&(r0_pagetable[KERNEL_STACK_BASE >> PAGESHIFT])),
-            (void *) next->region0_pt,
-            KS_NPG * (sizeof(struct pte)));
-
-    // Having changed the r0 page tables, flush the TLB
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+    // Restore the next region's kernel stack, flushing only the pages whose
+    // mappings differ
+    tlb_batch_init(&batch);
+    for (i = 0; i < KS_NPG; i++) {
+      tlb_set_pte(&batch, &r0_pagetable[(KERNEL_STACK_BASE >> PAGESHIFT) + i],
+          (void *) (KERNEL_STACK_BASE + (i << PAGESHIFT)),
+          (*(next->region0_pt + i)).valid, (*(next->region0_pt + i)).prot,
+          (*(next->region0_pt + i)).pfn);
+    }
+    tlb_batch_flush(&batch);
 
     // Restore the next Process' Region 1
     WriteRegister(REG_PTBR1, (unsigned int) next->region1_pt);
  
     // Having changed the r1 page tables, flush the TLB
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+    tlb_flush(TLB_FLUSH_1);
 
 
     TracePrintf(1, "End: MyKCSSwitch\n");
@@ -483,20 +567,26 @@ KernelContext *MyKCSSwitch(KernelContext *kc_in, void *curr_pcb_p, void *next_pc
  *
  * Returns 0 on success, -1 on failure
  *
- * IMPT: Assumes ready_procs is not empty
+ * IMPT: Assumes some process is ready to run
  */
 int switch_to_next_available_proc(UserContext *uc, int should_run_again){ 
   TracePrintf(1, "Start: switch_to_next_available_proc \n");
   
   // Put the old process on the ready queue if needed
   if (should_run_again) 
-    add_to_list(ready_procs, (void *) curr_proc, curr_proc->proc_id);
+    make_ready(curr_proc, SCHED_PREEMPT);
  
-  // Tries to switch to the next process in the ready queue
-  ListNode *node;
-  node = pop(ready_procs);
-  PCB_t *next_proc = node->data;
-  free(node);
+  // Tries to switch to the next process the scheduler picks
+  PCB_t *next_proc = sched_next();
+
+  // If that's the process that's already running, there's nothing to do
+  if (next_proc == curr_proc) {
+    kstats.switches_avoided++;
+    stats_set_state(curr_proc, STATE_RUNNING);
+    TracePrintf(1, "End: switch_to_next_available_proc (kept current)\n");
+    return SUCCESS;
+  }
+
   if (perform_context_switch(curr_proc, next_proc, uc) != 0) {
     TracePrintf(1, "Context Switch failed\n");
     TracePrintf(1, "End: switch_to_next_available_proc \n");
@@ -529,6 +619,7 @@ int perform_context_switch(PCB_t *curr, PCB_t *next, UserContext *uc) {
 
     // Update the current process global variable
     curr_proc = next;
+    stats_switch(curr, next);
     
     // Do the switch with magic function
     rc = KernelContextSwitch(MyKCSSwitch, (void *) curr, (void *) next);
@@ -566,8 +657,8 @@ int SetKernelBrk(void * addr) {
   TracePrintf(1, "Start: SetKernelBrk\n");
   // Check that the requested address is within the proper bounds of
   // where the break should ever be allowed to be
-  if ((unsigned int) addr > (unsigned int)KERNEL_STACK_BASE || addr < kernel_data_start) {
-    TracePrintf(1, "SetKernelBrk Error: address requested: %p not in bounds. KERNEL_STACK_BASE: %p, kernel_data_start: %p\n", addr, KERNEL_STACK_BASE, kernel_data_start);
+  if ((unsigned int) addr > (unsigned int) bcache_limit() || addr < kernel_data_start) {
+    TracePrintf(1, "SetKernelBrk Error: address requested: %p not in bounds. limit: %p, kernel_data_start: %p\n", addr, bcache_limit(), kernel_data_start);
     return -1;
   }
 
@@ -583,28 +674,35 @@ int SetKernelBrk(void * addr) {
     // Get the page values of the integers
     unsigned int bottom_page = VMEM_0_BASE >> PAGESHIFT;
     unsigned int addr_page = DOWN_TO_PAGE(addr) >> PAGESHIFT;
-    unsigned int bottom_of_stack = DOWN_TO_PAGE(KERNEL_STACK_BASE) >> PAGESHIFT;
+    unsigned int heap_limit = DOWN_TO_PAGE(bcache_limit()) >> PAGESHIFT;  // The buffer cache starts here
+
+    tlb_batch_t batch;
+
+    tlb_batch_init(&batch);
 
     // Loop through each vm page in the kernel up to the new break
     for (i = bottom_page; i <= addr_page; i++) {
         // Update pagetable if a page that should be valid is not
-        if (r0_pagetable[i].valid != 0x1) 
+        if (r0_pagetable[i].valid != 0x1) {
             r0_pagetable[i].valid = (u_long) 0x1; // Update the page table entry
-        
+            tlb_batch_add(&batch, (void *) (i << PAGESHIFT));
+        }
     }
     
     // Loop through what should be unallocated memory
-    for (i = addr_page + 1; i < bottom_of_stack; i++) {
+    for (i = addr_page + 1; i < heap_limit; i++) {
         // If the page is allocated, we need to free it
-        if (r0_pagetable[i].valid == 0x1) 
+        if (r0_pagetable[i].valid == 0x1) {
             r0_pagetable[i].valid = (u_long) 0x0; // Update the page table
+            tlb_batch_add(&batch, (void *) (i << PAGESHIFT));
+        }
     }
     
     // Set the new kernel break
     kernel_brk = addr;
 
-    // Flush the TLB register
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+    // Flush just the pages that changed
+    tlb_batch_flush(&batch);
 
     TracePrintf(1, "End: SetKernelBrk\n");
     return 0;
@@ -12,6 +12,16 @@
 #include "linked_list.h"
 #include "PCB.h"
 #include "traps.h"
+#include "frames.h"
+#include "resource.h"
+#include "delay.h"
+#include "sched.h"
+#include "stats.h"
+#include "tlb.h"
+#include "batch.h"
+#include "ipc.h"
+#include "disk.h"
+#include "bcache.h"
 
 /*
  * Constants
@@ -44,27 +54,31 @@ void *kernel_data_end;
 void *kernel_brk;
 unsigned int pframes_in_use;
 unsigned int pframes_in_kernel;
+int lazy_load;                // 1 to demand-page programs in LoadProgram
 
+// scheduling
+char *sched_policy;           // Name of the scheduler to use (see sched.h)
+int sched_quantum;            // Base scheduling quantum in clock ticks
 
-// locks/cvars/pipes/ttys
-int next_resource_id;
-List *locks;
-List *cvars;
-List *pipes;
-List *ttys;
+// performance counters (see stats.h)
+kstats_t kstats;
+
+
+// ttys live in tty.c; locks/cvars/pipes/semaphores live in the resource table
+unsigned int pipe_capacity;   // Bytes each new pipe holds (see pipe.h)
+unsigned int tty_out_capacity;  // Bytes in each terminal's output ring (see tty.h)
+int bcache_frames;            // Frames given to the buffer cache (see bcache.h)
 
 // processes 
 PCB_t *idle_proc; 
 PCB_t *curr_proc;
 unsigned int available_process_id;
 unsigned int total_pframes;
+unsigned int current_tick;    // Clock traps since boot
 
-// FrameList
-List FrameList;
-
-// process queues
-List *ready_procs;
-List *blocked_procs;
+// process queues (ready processes are queued by the scheduler, and blocked
+// processes sit on the queue of whatever they're blocked on: the delay
+// queue, a lock, a pipe, etc.)
 List *all_procs;
 List *dead_procs;
 
@@ -81,9 +95,13 @@ void KernelStart(char *cmd_args[],
 
 int SetKernelBrk(void *addr);
 
+int parse_kernel_args(char *cmd_args[]);
+
 void DoIdle();
 
 void *MyKCSClone(KernelContext *kc_in, void *curr_pcb_p, void *next_pcb_p);
 KernelContext *MyKCSSwitch(KernelContext *kc_in, void *curr_pcb_p, void *next_pcb_p);
+int switch_to_next_available_proc(UserContext *uc, int should_run_again);
+int perform_context_switch(PCB_t *curr, PCB_t *next, UserContext *uc);
 int bufferIsValid(char *buff, int len, void* permissions);
 #endif // _KERNEL_H_
@@ -17,6 +17,33 @@
 #include "kernel.h" 
 #include "PCB.h"
 
+/*
+ * Function: load_undo
+ *  @proc: the process LoadProgram was loading into
+ *  @pagetable: the region 1 page table LoadProgram was building
+ *  @old_ptbr1: what REG_PTBR1 held before LoadProgram switched to @pagetable
+ *
+ * Backs out of a failed load: gives back every frame mapped in
+ * @pagetable, drops the process' text reference, and puts the old
+ * region 1 page table back.
+ */
+static void load_undo(PCB_t *proc, struct pte *pagetable, unsigned int old_ptbr1) {
+  int i;
+
+  for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
+    if (pagetable[i].valid == (u_long) 0x1) {
+      free_frame(PFN_TO_FNUM(pagetable[i].pfn));
+      pagetable[i].valid = (u_long) 0x0;
+    }
+  }
+
+  text_release(proc->text);
+  proc->text = NULL;
+
+  WriteRegister(REG_PTBR1, old_ptbr1);
+  tlb_flush(TLB_FLUSH_1);
+}
+
 /*
  *  Load a program into an existing address space.  The program comes from
  *  the Linux file named "name", and its arguments come from the array at
@@ -47,6 +74,10 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   int stack_npg;
   long segment_size;
   char *argbuf;
+  int frames_needed;
+  int fnum;
+  tlb_batch_t batch;
+  page_info_t *info;
 
 
   /*
@@ -66,25 +97,29 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   // Save the current base pointer for afterward
   unsigned int old_proc_PTBR1 = ReadRegister(REG_PTBR1); 
   WriteRegister(REG_PTBR1, (unsigned int) proc_pagetable);
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  tlb_flush(TLB_FLUSH_1);
+  tlb_batch_init(&batch);
 
   /*
    * Open the executable file 
    */
   if ((fd = open(name, O_RDONLY)) < 0) {
     TracePrintf(0, "LoadProgram: can't open file '%s'\n", name);
+    load_undo(proc, proc_pagetable, old_proc_PTBR1);
     return ERROR;
   }
 
   if (LoadInfo(fd, &li) != LI_NO_ERROR) {
     TracePrintf(0, "LoadProgram: '%s' not in Yalnix format\n", name);
     close(fd);
+    load_undo(proc, proc_pagetable, old_proc_PTBR1);
     return (-1);
   }
 
   if (li.entry < VMEM_1_BASE) {
     TracePrintf(0, "LoadProgram: '%s' not linked for Yalnix\n", name);
     close(fd);
+    load_undo(proc, proc_pagetable, old_proc_PTBR1);
     return ERROR;
   }
 
@@ -149,6 +184,22 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   /* leave at least one page between heap and stack */
   if (stack_npg + data_pg1 + data_npg >= MAX_PT_LEN) {
     close(fd);
+    load_undo(proc, proc_pagetable, old_proc_PTBR1);
+    return ERROR;
+  }
+
+  /*
+   * make sure there are enough physical frames for the program (only the
+   * stack is allocated up front when demand paging)
+   */
+  frames_needed = stack_npg;
+  if (!lazy_load)
+    frames_needed += li.t_npg + data_npg;
+
+  if (frames_available() < frames_needed) {
+    TracePrintf(0, "LoadProgram: not enough free frames to load '%s'\n", name);
+    close(fd);
+    load_undo(proc, proc_pagetable, old_proc_PTBR1);
     return ERROR;
   }
 
@@ -158,6 +209,12 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
    * loading succesfully or killing the process.
    */
 
+  /*
+   * Share the text with any other process running this executable. If the
+   * text cache can't take it, the process just gets a private copy.
+   */
+  proc->text = text_acquire(name, li.t_faddr, li.t_npg);
+
   /*
    * Set the new stack pointer value in the process's exception frame.
    */
@@ -196,7 +253,7 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   for (; rg1_pt < rg1_pt + rg1_size; rg1_pt++) { 
     rg1_pt->valid = (u_long) 0x0;
     if (rg1_pt0->pfn != NULL)
-      add_to_list(&FrameList, (void *) NULL, (rg1_pt->pfn >> PAGESHIFT));
+      free_frame(PFN_TO_FNUM(rg1_pt->pfn));
   } */
 
 
@@ -204,12 +261,41 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
 // ==>> the "text_pg1" page in region 1 address space.  
 // ==>> These pages should be marked valid, with a protection of 
 // ==>> (PROT_READ | PROT_WRITE)
+  //
+  // When demand paging, the text and data pages are left invalid and
+  // marked PG_LAZY instead, with the file offset each one is read from.
+  // HANDLE_TRAP_MEMORY fills them in on first touch (see lazy_fill()).
+  // Shared text is mapped straight from the text cache's frames.
   TracePrintf(3, "\tLoadProgram: Allocating pages for text\n");
   for (i = text_pg1; i < text_pg1 + li.t_npg; i++) {
     struct pte entry;
-    entry.valid = (u_long) 0x1;
-    entry.prot = (u_long) (PROT_READ | PROT_WRITE);
-    entry.pfn = (u_long) ((pop(&FrameList)->id * PAGESIZE) >> PAGESHIFT);
+    info = proc->region1_info + i;
+    bzero((void *) info, sizeof(page_info_t));
+
+    if (lazy_load) {
+      entry.valid = (u_long) 0x0;
+      entry.prot = (u_long) (PROT_READ | PROT_EXEC);
+      entry.pfn = (u_long) 0x0;
+      info->flags = PG_LAZY;
+      info->seg = SEG_TEXT;
+      info->prot = (u_char) (PROT_READ | PROT_EXEC);
+      info->foff = li.t_faddr + ((i - text_pg1) << PAGESHIFT);
+    } else if (proc->text != NULL) {
+      if ((fnum = text_frame(proc->text, i - text_pg1, fd)) == ERROR) {
+        close(fd);
+        free(argbuf);
+        load_undo(proc, proc_pagetable, old_proc_PTBR1);
+        return KILL;
+      }
+      ref_frame(fnum);
+      entry.valid = (u_long) 0x1;
+      entry.prot = (u_long) (PROT_READ | PROT_EXEC);
+      entry.pfn = FNUM_TO_PFN(fnum);
+    } else {
+      entry.valid = (u_long) 0x1;
+      entry.prot = (u_long) (PROT_READ | PROT_WRITE);
+      entry.pfn = FNUM_TO_PFN(alloc_frame());
+    }
     proc_pagetable[i] = entry;
   }
 
@@ -220,9 +306,27 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   TracePrintf(3, "\tLoadProgram: Allocating pages for data\n");
   for (i = data_pg1; i < data_pg1 + data_npg; i++) {
     struct pte entry;
-    entry.valid = (u_long) 0x1;
-    entry.prot = (u_long) (PROT_READ | PROT_WRITE);
-    entry.pfn = (u_long) ((pop(&FrameList)->id * PAGESIZE) >> PAGESHIFT);
+    info = proc->region1_info + i;
+    bzero((void *) info, sizeof(page_info_t));
+
+    if (lazy_load) {
+      entry.valid = (u_long) 0x0;
+      entry.prot = (u_long) (PROT_READ | PROT_WRITE);
+      entry.pfn = (u_long) 0x0;
+      info->flags = PG_LAZY;
+      info->prot = (u_char) (PROT_READ | PROT_WRITE);
+      // Pages past the initialized data are bss, and are just zero-filled
+      if (i < data_pg1 + li.id_npg) {
+        info->seg = SEG_DATA;
+        info->foff = li.id_faddr + ((i - data_pg1) << PAGESHIFT);
+      } else {
+        info->seg = SEG_BSS;
+      }
+    } else {
+      entry.valid = (u_long) 0x1;
+      entry.prot = (u_long) (PROT_READ | PROT_WRITE);
+      entry.pfn = FNUM_TO_PFN(alloc_frame());
+    }
     proc_pagetable[i] = entry;
   }
 
@@ -239,8 +343,9 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
     struct pte entry;
     entry.valid = (u_long) 0x1;
     entry.prot = (u_long) (PROT_READ | PROT_WRITE);
-    entry.pfn = (u_long) ((pop(&FrameList)->id * PAGESIZE) >> PAGESHIFT);
+    entry.pfn = FNUM_TO_PFN(alloc_frame());
     proc_pagetable[i] = entry;
+    bzero((void *) (proc->region1_info + i), sizeof(page_info_t));
   }
 
 
@@ -252,32 +357,40 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   /*
    * Read the text from the file into memory.
    */
-  TracePrintf(3, "\tLoadProgram: Reading Text\n");
-  lseek(fd, li.t_faddr, SEEK_SET);
-  segment_size = li.t_npg << PAGESHIFT;
-  if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
-    close(fd);
+  if (!lazy_load) {
+    // Shared text was already read into the text cache's frames
+    if (proc->text == NULL) {
+      TracePrintf(3, "\tLoadProgram: Reading Text\n");
+      lseek(fd, li.t_faddr, SEEK_SET);
+      segment_size = li.t_npg << PAGESHIFT;
+      if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
+        close(fd);
+        free(argbuf);
+        load_undo(proc, proc_pagetable, old_proc_PTBR1);
 // ==>> KILL is not defined anywhere: it is an error code distinct
 // ==>> from ERROR because it requires different action in the caller.
 // ==>> Since this error code is internal to your kernel, you get to define it.
-    return KILL;
-  }
-  /*
-   * Read the data from the file into memory.
-   */
-  TracePrintf(3, "\tLoadProgram: Reading Data\n");
-  lseek(fd, li.id_faddr, 0);
-  segment_size = li.id_npg << PAGESHIFT;
-
-  if (read(fd, (void *) li.id_vaddr, segment_size) != segment_size) {
-    close(fd);
-    return KILL;
-  }
-
-  /*
-   * Now set the page table entries for the program text to be readable
-   * and executable, but not writable.
-   */
+        return KILL;
+      }
+    }
+    /*
+     * Read the data from the file into memory.
+     */
+    TracePrintf(3, "\tLoadProgram: Reading Data\n");
+    lseek(fd, li.id_faddr, 0);
+    segment_size = li.id_npg << PAGESHIFT;
+
+    if (read(fd, (void *) li.id_vaddr, segment_size) != segment_size) {
+      close(fd);
+      free(argbuf);
+      load_undo(proc, proc_pagetable, old_proc_PTBR1);
+      return KILL;
+    }
+
+    /*
+     * Now set the page table entries for the program text to be readable
+     * and executable, but not writable.
+     */
 
 // ==>> Change the protection on the "li.t_npg" pages starting at
 // ==>> virtual address VMEM_1_BASE + (text_pg1 << PAGESHIFT).  Note
@@ -290,8 +403,10 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
 // ==>> consistent.
 
 
-  for (i = text_pg1; i < text_pg1 + li.t_npg; i++) {
-      proc_pagetable[i].prot = (u_long) (PROT_READ | PROT_EXEC);
+    for (i = text_pg1; i < text_pg1 + li.t_npg; i++) {
+        tlb_set_pte(&batch, proc_pagetable + i, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+            proc_pagetable[i].valid, (u_long) (PROT_READ | PROT_EXEC), proc_pagetable[i].pfn);
+    }
   }
 
   //  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
@@ -299,12 +414,22 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   // at which this process' r1 page table is stored
   TracePrintf(3, "\tLoadProgram: Copying page table to proc's pointer\n");
   memcpy(proc->region1_pt, proc_pagetable, VMEM_1_PAGE_COUNT * sizeof(struct pte));
-  close(fd);			/* we've read it all now */
 
-  /*
-   * Zero out the uninitialized data area
-   */
-  bzero(li.id_end, li.ud_end - li.id_end);
+  if (lazy_load) {
+    /*
+     * Keep the executable open so the text and data can be paged in later.
+     * The uninitialized data is zeroed when each page is first touched.
+     */
+    proc->exec_fd = fd;
+    proc->data_end = li.id_end;
+  } else {
+    close(fd);			/* we've read it all now */
+
+    /*
+     * Zero out the uninitialized data area
+     */
+    bzero(li.id_end, li.ud_end - li.id_end);
+  }
 
   /*
    * Set the entry point in the exception frame.
@@ -316,7 +441,8 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
   /*
    * Now, finally, build the argument list on the new stack.
    */
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+  // Only the text pages' protections changed since the flush above
+  tlb_batch_flush(&batch);
 #ifdef LINUX
   memset(cpp, 0x00, VMEM_1_LIMIT - ((int) cpp));
   TracePrintf(1,"Past the memset\n");
@@ -342,7 +468,7 @@ LoadProgram(char *name, char *args[], PCB_t *proc)
 
   // Restore old PTBR1
   WriteRegister(REG_PTBR1, old_proc_PTBR1);
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  tlb_flush(TLB_FLUSH_1);
 
   TracePrintf(1, "Finished Loading in Program\n");
   return SUCCESS;
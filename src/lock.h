@@ -1,11 +1,12 @@
 #ifndef _LOCK_H_
 #define _LOCK_H_
+#include "queue.h"
 
 typedef struct LOCK_t { 
   int id; 
   int is_claimed; 
   int owner_id; 
-  List *waiters;
+  proc_queue_t waiters;
 } LOCK_t;
 
 #endif 
@@ -0,0 +1,461 @@
+/*
+ * File: paging.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Copy-on-write support for region 1. Fork shares every valid page of
+ *    the parent with the child instead of copying it: writable pages are
+ *    made read-only in both processes and marked PG_COW, and each frame's
+ *    reference count goes up by one. The first write to such a page traps
+ *    with YALNIX_ACCERR and cow_resolve() gives the writer a private copy
+ *    (or simply restores write access if it's the last one sharing).
+ *
+ *    Demand paging for LoadProgram also lives here. A lazy page is invalid
+ *    in the pte and marked PG_LAZY; the first touch traps with
+ *    YALNIX_MAPERR and lazy_fill() reads the page from the process'
+ *    executable (or zero-fills it, for bss). Text pages of a program in
+ *    the text cache are mapped from the cache's shared frames instead.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <unistd.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "frames.h"
+#include "paging.h"
+#include "textcache.h"
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: cow_share_pages
+ *  @parent: the forking process (must be the current process)
+ *  @child: the new process, whose region1_pt and region1_info are allocated
+ *
+ * Copies the parent's region 1 page table and page info into the child
+ * and shares every valid frame between them copy-on-write.
+ *
+ * Returns SUCCESS.
+ */
+int cow_share_pages(PCB_t *parent, PCB_t *child) {
+  struct pte *pte;
+  tlb_batch_t batch;
+  int i;
+
+  tlb_batch_init(&batch);
+
+  for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
+    pte = parent->region1_pt + i;
+
+    if (pte->valid == (u_long) 0x1) {
+      // One more page maps this frame now
+      ref_frame(PFN_TO_FNUM(pte->pfn));
+
+      // Writable pages become read-only in both processes until written
+      if (pte->prot & PROT_WRITE) {
+        tlb_set_pte(&batch, pte, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+            pte->valid, (u_long) (pte->prot & ~PROT_WRITE), pte->pfn);
+        (parent->region1_info + i)->flags |= PG_COW;
+      }
+    }
+
+    *(child->region1_pt + i) = *pte;
+    *(child->region1_info + i) = *(parent->region1_info + i);
+
+    // Invalid pages never carry a pfn
+    if ((child->region1_pt + i)->valid != (u_long) 0x1)
+      (child->region1_pt + i)->pfn = (u_long) 0x0;
+  }
+
+  // The parent's writable pages just lost write access
+  tlb_batch_flush(&batch);
+  forget_user_ranges(parent);
+
+  return SUCCESS;
+}
+
+/*
+ * Function: cow_resolve
+ *  @proc: the process writing to the page (must be the current process)
+ *  @page: index of the page in region 1
+ *
+ * Gives the process a private, writable copy of a copy-on-write page.
+ * If no other process still shares the frame, the frame is kept and only
+ * write access is restored.
+ *
+ * Returns SUCCESS, or ERROR if the page isn't COW or no frames are left.
+ */
+int cow_resolve(PCB_t *proc, int page) {
+  struct pte *pte;
+  page_info_t *info;
+  int old_fnum;
+  int new_fnum;
+  void *dest;
+
+  if (page < 0 || page >= VMEM_1_PAGE_COUNT)
+    return ERROR;
+
+  pte = proc->region1_pt + page;
+  info = proc->region1_info + page;
+
+  if (pte->valid != (u_long) 0x1 || !(info->flags & PG_COW))
+    return ERROR;
+
+  old_fnum = PFN_TO_FNUM(pte->pfn);
+
+  // Someone else still maps this frame, so copy it
+  if (frame_refcount(old_fnum) > 1) {
+    if ((new_fnum = alloc_frame()) == ERROR) {
+      TracePrintf(3, "cow_resolve: no frames left to copy page %d of process %d\n",
+          page, proc->proc_id);
+      return ERROR;
+    }
+
+    dest = map_scratch_frame(new_fnum);
+    memcpy(dest, (void *) (VMEM_1_BASE + (page << PAGESHIFT)), PAGESIZE);
+    unmap_scratch_frame();
+
+    pte->pfn = FNUM_TO_PFN(new_fnum);
+    free_frame(old_fnum);
+  }
+
+  pte->prot = (u_long) (PROT_READ | PROT_WRITE);
+  info->flags &= ~PG_COW;
+  tlb_flush_page((void *) (VMEM_1_BASE + (page << PAGESHIFT)));
+
+  return SUCCESS;
+}
+
+/*
+ * Function: lazy_fill
+ *  @proc: the process touching the page (must be the current process)
+ *  @page: index of the page in region 1
+ *
+ * Gives a PG_LAZY page a frame and fills it: text and data pages are read
+ * from the executable at the page's file offset, and bss pages are zeroed.
+ * The part of the last data page past the end of the initialized data is
+ * bss too, so it gets zeroed after the read. Shared text pages just map
+ * the text cache's frame for the page.
+ *
+ * Returns SUCCESS, or ERROR if no frame is free or the read failed.
+ */
+int lazy_fill(PCB_t *proc, int page) {
+  struct pte *pte;
+  page_info_t *info;
+  int fnum;
+  int nread;
+  unsigned int addr;
+
+  if (page < 0 || page >= VMEM_1_PAGE_COUNT)
+    return ERROR;
+
+  pte = proc->region1_pt + page;
+  info = proc->region1_info + page;
+
+  if (!(info->flags & PG_LAZY))
+    return ERROR;
+
+  // Shared text only needs to be read once, by whoever touches it first
+  if (info->seg == SEG_TEXT && proc->text != NULL) {
+    fnum = text_frame(proc->text, (info->foff - proc->text->faddr) >> PAGESHIFT,
+        proc->exec_fd);
+    if (fnum == ERROR)
+      return ERROR;
+
+    ref_frame(fnum);
+    pte->valid = (u_long) 0x1;
+    pte->prot = (u_long) info->prot;
+    pte->pfn = FNUM_TO_PFN(fnum);
+    info->flags &= ~PG_LAZY;
+    tlb_flush_page((void *) (VMEM_1_BASE + (page << PAGESHIFT)));
+
+    return SUCCESS;
+  }
+
+  if ((fnum = alloc_frame()) == ERROR) {
+    TracePrintf(3, "lazy_fill: no frames left for page %d of process %d\n",
+        page, proc->proc_id);
+    return ERROR;
+  }
+
+  // Map it writable while we fill it
+  addr = VMEM_1_BASE + (page << PAGESHIFT);
+  pte->valid = (u_long) 0x1;
+  pte->prot = (u_long) (PROT_READ | PROT_WRITE);
+  pte->pfn = FNUM_TO_PFN(fnum);
+  tlb_flush_page((void *) addr);
+
+  if (info->seg == SEG_BSS) {
+    bzero((void *) addr, PAGESIZE);
+  } else {
+    nread = -1;
+    if (proc->exec_fd >= 0 && lseek(proc->exec_fd, info->foff, SEEK_SET) >= 0)
+      nread = read(proc->exec_fd, (void *) addr, PAGESIZE);
+
+    if (nread < 0) {
+      TracePrintf(3, "lazy_fill: failed to read page %d of process %d\n",
+          page, proc->proc_id);
+      pte->valid = (u_long) 0x0;
+      pte->pfn = (u_long) 0x0;
+      tlb_flush_page((void *) addr);
+      free_frame(fnum);
+      return ERROR;
+    }
+
+    // A short read at the end of the file leaves the rest of the page
+    if (nread < PAGESIZE)
+      bzero((void *) (addr + nread), PAGESIZE - nread);
+
+    // Zero the start of bss if it shares this page with initialized data
+    if (info->seg == SEG_DATA && proc->data_end > addr &&
+        proc->data_end < addr + PAGESIZE)
+      bzero((void *) proc->data_end, addr + PAGESIZE - proc->data_end);
+  }
+
+  pte->prot = (u_long) info->prot;
+  info->flags &= ~PG_LAZY;
+  tlb_flush_page((void *) addr);
+
+  return SUCCESS;
+}
+
+/*
+ * Function: prepare_user_range
+ *  @proc: the current process
+ *  @addr: start of a region 1 buffer the kernel is about to use
+ *  @len: length of the buffer in bytes
+ *  @write: nonzero if the kernel will write into the buffer
+ *
+ * The kernel is held to the same page mappings and protections as user
+ * code, so before a syscall touches a user buffer every lazy page under
+ * it has to be loaded, and (for output buffers) every COW page resolved.
+ *
+ * Returns SUCCESS, or ERROR if a page couldn't be made ready.
+ */
+int prepare_user_range(PCB_t *proc, void *addr, int len, int write) {
+  page_info_t *info;
+  int first_pg;
+  int last_pg;
+  int i;
+
+  if (len <= 0)
+    return SUCCESS;
+
+  if ((unsigned int) addr < VMEM_1_BASE ||
+      (unsigned int) addr + len > VMEM_1_LIMIT)
+    return ERROR;
+
+  first_pg = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+  last_pg = (DOWN_TO_PAGE((unsigned int) addr + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+
+  for (i = first_pg; i <= last_pg; i++) {
+    info = proc->region1_info + i;
+
+    if ((info->flags & PG_LAZY) && lazy_fill(proc, i) != SUCCESS)
+      return ERROR;
+
+    if (write && (info->flags & PG_COW) && cow_resolve(proc, i) != SUCCESS)
+      return ERROR;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: check_user_range
+ *  @proc: the current process
+ *  @addr: start of a region 1 buffer the kernel is about to use
+ *  @len: length of the buffer in bytes
+ *  @prot: PROT_* access the kernel needs to every byte of it
+ *
+ * Validates a syscall's buffer argument in one pass: the whole range has
+ * to be in region 1, and every page it touches (the first and last
+ * partial pages too) has to be valid with at least @prot. Lazy pages are
+ * loaded, and COW pages resolved if @prot includes PROT_WRITE, first.
+ *
+ * The last range that passed is remembered in the PCB, so a process that
+ * keeps passing the same buffer (a TtyWrite or PipeWrite loop) only has
+ * it checked once. forget_user_ranges() has to be called whenever pages
+ * of the process lose validity or protection.
+ *
+ * Returns SUCCESS, or ERROR if the buffer can't be used.
+ */
+int check_user_range(PCB_t *proc, void *addr, int len, int prot) {
+  unsigned int lo = (unsigned int) addr;
+  unsigned int hi = lo + len;
+  struct pte *pte;
+  int first_pg;
+  int last_pg;
+  int i;
+
+  if (len < 0 || lo < VMEM_1_BASE || hi > VMEM_1_LIMIT || hi < lo)
+    return ERROR;
+
+  // Checked already
+  if (lo >= proc->chk_lo && hi <= proc->chk_hi && (proc->chk_prot & prot) == prot)
+    return SUCCESS;
+
+  if (len == 0)
+    return SUCCESS;
+
+  if (prepare_user_range(proc, addr, len, prot & PROT_WRITE) != SUCCESS)
+    return ERROR;
+
+  first_pg = (DOWN_TO_PAGE(lo) - VMEM_1_BASE) >> PAGESHIFT;
+  last_pg = (DOWN_TO_PAGE(hi - 1) - VMEM_1_BASE) >> PAGESHIFT;
+
+  for (i = first_pg; i <= last_pg; i++) {
+    pte = proc->region1_pt + i;
+    if (pte->valid != (u_long) 0x1 || (pte->prot & prot) != prot)
+      return ERROR;
+  }
+
+  proc->chk_lo = lo;
+  proc->chk_hi = hi;
+  proc->chk_prot = prot;
+  return SUCCESS;
+}
+
+/*
+ * Function: forget_user_ranges
+ *  @proc: a process whose region 1 mappings were just taken away or made
+ *         read-only
+ *
+ * Drops the range check_user_range() remembered.
+ */
+void forget_user_ranges(PCB_t *proc) {
+  proc->chk_lo = 0;
+  proc->chk_hi = 0;
+  proc->chk_prot = 0;
+}
+
+/*
+ * Function: prepare_user_string
+ *  @proc: the current process
+ *  @str: a NUL-terminated string in region 1
+ *
+ * Like prepare_user_range, but for a string whose length isn't known
+ * until its pages are loaded: loads one page at a time up to the NUL.
+ *
+ * Returns SUCCESS, or ERROR if the string runs off a valid page.
+ */
+int prepare_user_string(PCB_t *proc, char *str) {
+  unsigned int addr = (unsigned int) str;
+  unsigned int page_end;
+
+  while (1) {
+    if (addr < VMEM_1_BASE || addr >= VMEM_1_LIMIT)
+      return ERROR;
+
+    if (prepare_user_range(proc, (void *) addr, 1, 0) != SUCCESS)
+      return ERROR;
+
+    if ((proc->region1_pt + ((addr - VMEM_1_BASE) >> PAGESHIFT))->valid != (u_long) 0x1)
+      return ERROR;
+
+    // Scan the rest of this page for the terminator
+    page_end = DOWN_TO_PAGE(addr) + PAGESIZE;
+    for (; addr < page_end; addr++) {
+      if (*((char *) addr) == '\0')
+        return SUCCESS;
+    }
+  }
+}
+
+/*
+ * Function: copy_to_proc
+ *  @proc: a process other than the current one
+ *  @dest: region 1 address in @proc to copy to
+ *  @src: kernel or current-process address to copy from
+ *  @len: number of bytes
+ *
+ * Copies into another process' memory a page at a time by mapping each of
+ * its frames at the scratch page, the way Fork copies the kernel stack.
+ * The destination must already be loaded and writable (e.g. by
+ * prepare_user_range() when @proc made the syscall it's blocked in).
+ *
+ * Returns SUCCESS, or ERROR if a destination page isn't ready.
+ */
+int copy_to_proc(PCB_t *proc, void *dest, void *src, int len) {
+  unsigned int addr = (unsigned int) dest;
+  unsigned int off;
+  struct pte *pte;
+  char *page;
+  int n;
+
+  if (addr < VMEM_1_BASE || addr + len > VMEM_1_LIMIT)
+    return ERROR;
+
+  while (len > 0) {
+    pte = proc->region1_pt + ((addr - VMEM_1_BASE) >> PAGESHIFT);
+    if (pte->valid != (u_long) 0x1 || !(pte->prot & PROT_WRITE))
+      return ERROR;
+
+    off = addr & PAGEOFFSET;
+    n = (len < PAGESIZE - off) ? len : PAGESIZE - off;
+
+    page = (char *) map_scratch_frame(PFN_TO_FNUM(pte->pfn));
+    memcpy(page + off, src, n);
+    unmap_scratch_frame();
+
+    addr += n;
+    src = (char *) src + n;
+    len -= n;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: copy_from_proc
+ *  @proc: a process other than the current one
+ *  @dest: kernel or current-process address to copy to
+ *  @src: region 1 address in @proc to copy from
+ *  @len: number of bytes
+ *
+ * The reverse of copy_to_proc(). The source pages only have to be loaded,
+ * so a page @proc shares copy-on-write is read in place.
+ *
+ * Returns SUCCESS, or ERROR if a source page isn't loaded.
+ */
+int copy_from_proc(PCB_t *proc, void *dest, void *src, int len) {
+  unsigned int addr = (unsigned int) src;
+  unsigned int off;
+  struct pte *pte;
+  char *page;
+  int n;
+
+  if (addr < VMEM_1_BASE || addr + len > VMEM_1_LIMIT)
+    return ERROR;
+
+  while (len > 0) {
+    pte = proc->region1_pt + ((addr - VMEM_1_BASE) >> PAGESHIFT);
+    if (pte->valid != (u_long) 0x1)
+      return ERROR;
+
+    off = addr & PAGEOFFSET;
+    n = (len < PAGESIZE - off) ? len : PAGESIZE - off;
+
+    page = (char *) map_scratch_frame(PFN_TO_FNUM(pte->pfn));
+    memcpy(dest, page + off, n);
+    unmap_scratch_frame();
+
+    addr += n;
+    dest = (char *) dest + n;
+    len -= n;
+  }
+
+  return SUCCESS;
+}
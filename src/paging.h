@@ -0,0 +1,78 @@
+/*
+ * File:  paging.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Software bookkeeping for region 1 pages that the hardware pte can't
+ *    hold. Every process has one page_info_t per region 1 page, indexed
+ *    the same way as its region1_pt.
+ *
+ * Contents:
+ *    page_info_t         - Per-page software state
+ *    cow_share_pages()   - Share a parent's region 1 with a forked child
+ *    cow_resolve()       - Give a process a private copy of a COW page
+ *    lazy_fill()         - Load a demand-paged page on first touch
+ *    prepare_user_range() - Fault in / un-COW every page of a user buffer
+ *    prepare_user_string() - Fault in every page of a user string
+ *    check_user_range()  - Validate a syscall buffer, remembering the last one
+ *    forget_user_ranges() - Drop the remembered range after unmapping pages
+ *    copy_to_proc()      - Copy into another process' region 1
+ *    copy_from_proc()    - Copy out of another process' region 1
+ *
+ * Warnings:
+ *    cow_resolve() and lazy_fill() work through the page's region 1
+ *    address, so they must be called on behalf of the current process.
+ *    copy_to_proc() and copy_from_proc() are the opposite: they never
+ *    touch region 1 directly.
+ */
+
+#ifndef _PAGING_H_
+#define _PAGING_H_
+
+/*
+ * System includes
+ */
+#include <hardware.h>
+
+/*
+ * Public Constant Definitions
+ */
+// Page flag constants
+#define PG_COW            ((u_char) 0x1)    // Shared copy-on-write frame
+#define PG_LAZY           ((u_char) 0x2)    // Not loaded yet; fill on first touch
+
+// Segment constants (which part of the executable a lazy page comes from)
+#define SEG_NONE          ((u_char) 0x0)
+#define SEG_TEXT          ((u_char) 0x1)
+#define SEG_DATA          ((u_char) 0x2)
+#define SEG_BSS           ((u_char) 0x3)
+
+/*
+ * page_info_t datatype
+ *
+ * Software state for a single region 1 page.
+ */
+typedef struct page_info_t {
+  u_char flags;             // PG_* flags for this page
+  u_char seg;               // SEG_* segment this page was loaded from
+  u_char prot;              // Protection to give a lazy page once it's loaded
+  long foff;                // File offset of a lazy text/data page's contents
+} page_info_t;
+
+/*
+ * Public Prototypes
+ */
+struct PCB_t;
+
+int cow_share_pages(struct PCB_t *parent, struct PCB_t *child);
+int cow_resolve(struct PCB_t *proc, int page);
+int lazy_fill(struct PCB_t *proc, int page);
+int prepare_user_range(struct PCB_t *proc, void *addr, int len, int write);
+int prepare_user_string(struct PCB_t *proc, char *str);
+int check_user_range(struct PCB_t *proc, void *addr, int len, int prot);
+void forget_user_ranges(struct PCB_t *proc);
+int copy_to_proc(struct PCB_t *proc, void *dest, void *src, int len);
+int copy_from_proc(struct PCB_t *proc, void *dest, void *src, int len);
+
+#endif // _PAGING_H_
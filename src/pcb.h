@@ -3,6 +3,10 @@
 #include "linked_list.h"
 #include "tty.h"
 #include "blocks.h"
+#include "paging.h"
+#include "textcache.h"
+#include "queue.h"
+#include "stats.h"
 
 /*
  * Type Definitions and Structures
@@ -14,9 +18,17 @@ typedef struct PCB_t {
   KernelContext *kc_p;
   block_t *block;
 
-  // Must be allocted when creating the process
+  // Links for whichever proc_queue_t (ready queue or wait queue) we're on
+  struct PCB_t *q_next;
+  struct PCB_t *q_prev;
+  proc_queue_t *q_on;
+  int sched_level;        // Scheduler priority level (0 is highest)
+  int sched_ticks;        // Ticks run since last dispatched
+
+  // Must be allocted when creating the process (see alloc_page_tables())
   struct pte *region0_pt;
   struct pte *region1_pt;
+  page_info_t *region1_info;  // Allocated in new_process(), parallels region1_pt
 
   // Initialized to 0 or null
   List *children;         // Allocate in Fork
@@ -27,14 +39,38 @@ typedef struct PCB_t {
   unsigned int brk_addr;
   int kc_set;             // Set to 1 after a MyKCSClone call
 
-  buffer *write_buf; 
-  int read_len;
+  int exec_fd;            // Open executable for demand paging, or -1
+  unsigned int data_end;  // End of initialized data (bss starts here)
+  text_t *text;           // Shared text this process runs, or NULL
+
+  // Last user buffer check_user_range() passed, and the access it allows
+  unsigned int chk_lo;
+  unsigned int chk_hi;
+  int chk_prot;
+
+  pstats_t stats;         // Performance counters (see stats.h)
+  int stat_state;         // STATE_* the process is in, for tick accounting
+  unsigned int stat_since;  // Tick it entered stat_state
+
+  int read_len;           // Bytes wanted by a blocked PipeRead
+  void *read_buf;         // Where a blocked PipeRead wants them
+  int read_got;           // Bytes already copied to read_buf, or ERROR
+  int write_len;          // Bytes a blocked PipeWrite still has to write
+
+  // Message passing (see ipc.h)
+  int ipc_state;          // IPC_* state
+  int ipc_peer;           // Process we're sending to, received by, or receiving from
+  void *ipc_buf;          // Our message buffer while blocked in Send or Receive
+  int ipc_result;         // What the blocked Send or Receive returns
+  proc_queue_t ipc_senders;  // Senders waiting for us to Receive
 } PCB_t;
   
 /*
  * Function Declarations
  */
 PCB_t *new_process(UserContext *uc);
+int alloc_page_tables(PCB_t *pcb);
+void free_process(PCB_t *pcb);
 
 // Functions to work with the Process Control Blocks
 #endif // _PCB_H_
@@ -6,15 +6,44 @@
 
 #ifndef _PIPE_H_
 #define _PIPE_H_
+#include "queue.h"
 
-// Maximum info stored in a pipe at one time is 1 KB
+// Default capacity of a pipe (1 KB); change it with the -pipesz kernel option
 #define MAX_PIPE_LEN  1024
 
+// Pipe capacities are powers of two between these
+#define MIN_PIPE_LEN  16
+#define PIPE_LEN_LIMIT  (1 << 20)
+
+/*
+ * A pipe's data lives in a ring of cap bytes. head and tail count every
+ * byte ever read and written; they're only masked down to an index into
+ * buf when the ring is touched, so the pipe is full when tail - head is
+ * cap and empty when they're equal.
+ *
+ * Readers and writers each wait in FIFO order. A blocked reader first
+ * takes whatever is in the pipe, so while anyone is waiting to read the
+ * pipe is empty and writers copy straight into the reader's buffer
+ * instead (see copy_to_proc()); data only goes through buf when nobody
+ * is waiting for it. A writer woken for room has it set aside in
+ * room_owed until it runs, so nobody who shows up in the meantime can
+ * take it.
+ */
 typedef struct pipe_t {
   int id;
-  int len;
   char *buf;
-  List *waiters;
+  unsigned int cap;         // Size of buf, a power of two
+  unsigned int head;        // Bytes read from the pipe so far
+  unsigned int tail;        // Bytes written to the pipe so far
+  unsigned int room_owed;   // Room set aside for writers already woken
+  proc_queue_t waiters;     // Readers blocked until they have read_len bytes
+  proc_queue_t writers;     // Writers blocked until there's room
 } pipe_t;
 
+#define PIPE_LEN(p)     ((p)->tail - (p)->head)
+#define PIPE_ROOM(p)    ((p)->cap - PIPE_LEN(p))
+
+// Room a writer that isn't owed any may use right now
+#define PIPE_FREE_ROOM(p)   (PIPE_ROOM(p) - (p)->room_owed)
+
 #endif // _PIPE_H_
@@ -0,0 +1,120 @@
+/*
+ * File: queue.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the intrusive process queues declared in queue.h.
+ *    Each queue is a doubly linked list threaded through the PCBs on it,
+ *    with head and tail pointers. q_on points back at the queue a process
+ *    is on (or is NULL), which is what lets a process be unlinked without
+ *    knowing which queue it's waiting in.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "PCB.h"
+#include "queue.h"
+
+/*
+ * Function: init_queue
+ *  @q: the queue to empty (its old contents are not unlinked)
+ */
+void init_queue(proc_queue_t *q) {
+  q->head = NULL;
+  q->tail = NULL;
+  q->count = 0;
+}
+
+/*
+ * Function: enqueue
+ *  @q: the queue to add to
+ *  @proc: the process to add at the tail
+ */
+void enqueue(proc_queue_t *q, PCB_t *proc) {
+  if (proc->q_on != NULL) {
+    TracePrintf(3, "enqueue: process %d is already queued; moving it\n", proc->proc_id);
+    dequeue_proc(proc);
+  }
+
+  proc->q_next = NULL;
+  proc->q_prev = q->tail;
+  proc->q_on = q;
+
+  if (q->tail != NULL)
+    q->tail->q_next = proc;
+  else
+    q->head = proc;
+
+  q->tail = proc;
+  q->count++;
+}
+
+/*
+ * Function: dequeue
+ *  @q: the queue to take from
+ *
+ * Returns the process that was at the head, or NULL if the queue is empty.
+ */
+PCB_t *dequeue(proc_queue_t *q) {
+  PCB_t *proc = q->head;
+
+  if (proc != NULL)
+    dequeue_proc(proc);
+
+  return proc;
+}
+
+/*
+ * Function: queue_head
+ *  @q: the queue to look at
+ *
+ * Returns the process at the head without removing it, or NULL.
+ */
+PCB_t *queue_head(proc_queue_t *q) {
+  return q->head;
+}
+
+/*
+ * Function: dequeue_proc
+ *  @proc: the process to unlink (nothing happens if it isn't queued)
+ */
+void dequeue_proc(PCB_t *proc) {
+  proc_queue_t *q = proc->q_on;
+
+  if (q == NULL)
+    return;
+
+  if (proc->q_prev != NULL)
+    proc->q_prev->q_next = proc->q_next;
+  else
+    q->head = proc->q_next;
+
+  if (proc->q_next != NULL)
+    proc->q_next->q_prev = proc->q_prev;
+  else
+    q->tail = proc->q_prev;
+
+  q->count--;
+  proc->q_next = NULL;
+  proc->q_prev = NULL;
+  proc->q_on = NULL;
+}
+
+/*
+ * Function: queue_count
+ *  @q: the queue to count
+ *
+ * Returns the number of processes on the queue.
+ */
+int queue_count(proc_queue_t *q) {
+  return q->count;
+}
@@ -0,0 +1,52 @@
+/*
+ * File:  queue.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Intrusive FIFO queues of processes. The links live in the PCB itself
+ *    (q_next, q_prev, q_on), so queueing a process never allocates, and
+ *    enqueue, dequeue, removing a process from the middle of its queue,
+ *    and counting are all O(1). Used for the ready queue and for the
+ *    processes waiting on locks, cvars, semaphores, pipes, and
+ *    terminals.
+ *
+ * Contents:
+ *    proc_queue_t        - A queue of processes
+ *    init_queue()        - Make a queue empty
+ *    enqueue()           - Add a process at the tail
+ *    dequeue()           - Take the process at the head
+ *    queue_head()        - Look at the process at the head
+ *    dequeue_proc()      - Take a process off whatever queue it's on
+ *    queue_count()       - Number of processes on a queue
+ *
+ * Warnings:
+ *    A process can only be on one queue at a time. Enqueueing a process
+ *    that's already queued moves it (and traces a warning).
+ */
+
+#ifndef _QUEUE_H_
+#define _QUEUE_H_
+
+/*
+ * proc_queue_t datatype
+ */
+struct PCB_t;
+
+typedef struct proc_queue_t {
+  struct PCB_t *head;       // Next process to come off the queue
+  struct PCB_t *tail;       // Most recently added process
+  int count;                // Number of processes on the queue
+} proc_queue_t;
+
+/*
+ * Public Prototypes
+ */
+void init_queue(proc_queue_t *q);
+void enqueue(proc_queue_t *q, struct PCB_t *proc);
+struct PCB_t *dequeue(proc_queue_t *q);
+struct PCB_t *queue_head(proc_queue_t *q);
+void dequeue_proc(struct PCB_t *proc);
+int queue_count(proc_queue_t *q);
+
+#endif // _QUEUE_H_
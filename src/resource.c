@@ -0,0 +1,206 @@
+/*
+ * File: resource.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the resource table declared in resource.h. Free
+ *    slots are chained through their next_free field, so allocating and
+ *    freeing an id is O(1). The table starts small and doubles (up to
+ *    RES_MAX_SLOTS) when every slot is in use.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <stdlib.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "resource.h"
+
+/*
+ * Private Types
+ */
+typedef struct res_slot_t {
+  int type;                 // RES_* type of the resource, RES_NONE if free
+  int gen;                  // Generation of the slot's current (or next) id
+  int next_free;            // Next free slot, or -1
+  void *obj;                // The lock, cvar, pipe, or semaphore
+} res_slot_t;
+
+/*
+ * Private Variables
+ */
+static res_slot_t *res_table;     // The table itself
+static int res_size;              // Number of slots in the table
+static int res_free_head;         // First free slot, or -1
+
+#define RES_INITIAL_SLOTS   64
+
+/*
+ * Private Functions
+ */
+
+/*
+ * Function: res_grow
+ *
+ * Doubles the table, chaining the new slots onto the free list.
+ *
+ * Returns SUCCESS, or ERROR if the table is already as big as it gets or
+ * the kernel heap is out of space.
+ */
+static int res_grow() {
+  res_slot_t *bigger;
+  int new_size;
+  int i;
+
+  new_size = (res_size == 0) ? RES_INITIAL_SLOTS : res_size * 2;
+  if (new_size > RES_MAX_SLOTS)
+    return ERROR;
+
+  bigger = (res_slot_t *) realloc(res_table, new_size * sizeof(res_slot_t));
+  if (bigger == NULL)
+    return ERROR;
+
+  for (i = res_size; i < new_size; i++) {
+    bigger[i].type = RES_NONE;
+    bigger[i].gen = 0;
+    bigger[i].obj = NULL;
+    bigger[i].next_free = (i + 1 < new_size) ? i + 1 : res_free_head;
+  }
+
+  res_free_head = res_size;
+  res_table = bigger;
+  res_size = new_size;
+
+  return SUCCESS;
+}
+
+/*
+ * Function: res_slot
+ *  @id: a resource id
+ *
+ * Returns the slot the id refers to, or NULL if the id is malformed or has
+ * been reclaimed.
+ */
+static res_slot_t *res_slot(int id) {
+  int index;
+  res_slot_t *slot;
+
+  if (id < 0)
+    return NULL;
+
+  index = id & (RES_MAX_SLOTS - 1);
+  if (index >= res_size)
+    return NULL;
+
+  slot = res_table + index;
+  if (slot->type == RES_NONE || slot->gen != (id >> RES_INDEX_BITS))
+    return NULL;
+
+  return slot;
+}
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_resources
+ *
+ * Returns SUCCESS, or ERROR if the table couldn't be allocated.
+ */
+int init_resources() {
+  res_table = NULL;
+  res_size = 0;
+  res_free_head = -1;
+
+  return res_grow();
+}
+
+/*
+ * Function: res_alloc
+ *  @type: RES_* type of the object
+ *  @obj: the object to look up by the new id
+ *
+ * Returns a new id for the object, or ERROR if no more ids can be made.
+ */
+int res_alloc(int type, void *obj) {
+  res_slot_t *slot;
+  int index;
+
+  if (res_free_head < 0 && res_grow() != SUCCESS) {
+    TracePrintf(3, "res_alloc: out of resource ids\n");
+    return ERROR;
+  }
+
+  index = res_free_head;
+  slot = res_table + index;
+  res_free_head = slot->next_free;
+
+  slot->type = type;
+  slot->obj = obj;
+  slot->next_free = -1;
+
+  return (slot->gen << RES_INDEX_BITS) | index;
+}
+
+/*
+ * Function: res_lookup
+ *  @id: a resource id passed in by a user program
+ *  @type: the RES_* type the caller expects
+ *
+ * Returns the object behind the id, or NULL if the id isn't a live
+ * resource of that type.
+ */
+void *res_lookup(int id, int type) {
+  res_slot_t *slot = res_slot(id);
+
+  if (slot == NULL || slot->type != type)
+    return NULL;
+
+  return slot->obj;
+}
+
+/*
+ * Function: res_type
+ *  @id: a resource id
+ *
+ * Returns the RES_* type of the resource, or RES_NONE if it doesn't exist.
+ */
+int res_type(int id) {
+  res_slot_t *slot = res_slot(id);
+
+  return (slot == NULL) ? RES_NONE : slot->type;
+}
+
+/*
+ * Function: res_free
+ *  @id: the id of a resource being reclaimed
+ *
+ * Bumps the slot's generation, so the id (and any copy of it a user
+ * program kept) no longer finds anything, and puts the slot back on the
+ * free list.
+ *
+ * Returns SUCCESS, or ERROR if the id isn't a live resource.
+ */
+int res_free(int id) {
+  res_slot_t *slot = res_slot(id);
+
+  if (slot == NULL)
+    return ERROR;
+
+  slot->type = RES_NONE;
+  slot->obj = NULL;
+  slot->gen = (slot->gen + 1) & RES_GEN_MASK;
+  slot->next_free = res_free_head;
+  res_free_head = slot - res_table;
+
+  return SUCCESS;
+}
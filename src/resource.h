@@ -0,0 +1,53 @@
+/*
+ * File:  resource.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The resource table, which maps the ids handed out by LockInit,
+ *    CvarInit, PipeInit, and SemInit to the kernel objects behind them. An id is
+ *    the index of a slot in the table plus a generation tag, so lookups
+ *    are a single array access and an id stops working as soon as its
+ *    resource is reclaimed, even after the slot is reused.
+ *
+ * Contents:
+ *    RES_*               - Resource types
+ *    init_resources()    - Allocate the table
+ *    res_alloc()         - Give an object an id
+ *    res_lookup()        - Find the object of a given type behind an id
+ *    res_type()          - Type of the resource behind an id
+ *    res_free()          - Retire an id
+ *
+ * Warnings:
+ *    The table only holds pointers; freeing the object itself is up to
+ *    the caller of res_free().
+ */
+
+#ifndef _RESOURCE_H_
+#define _RESOURCE_H_
+
+/*
+ * Public Constant Definitions
+ */
+// Resource types
+#define RES_NONE          0
+#define RES_LOCK          1
+#define RES_CVAR          2
+#define RES_PIPE          3
+#define RES_SEM           4
+
+// An id is (generation << RES_INDEX_BITS) | slot
+#define RES_INDEX_BITS    16
+#define RES_MAX_SLOTS     (1 << RES_INDEX_BITS)
+#define RES_GEN_MASK      0x7fff    // Keeps ids positive
+
+/*
+ * Public Prototypes
+ */
+int init_resources();
+int res_alloc(int type, void *obj);
+void *res_lookup(int id, int type);
+int res_type(int id);
+int res_free(int id);
+
+#endif // _RESOURCE_H_
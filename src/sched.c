@@ -0,0 +1,289 @@
+/*
+ * File: sched.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The scheduler front end declared in sched.h, and the two policies
+ *    behind it. Both keep their ready processes on intrusive queues (see
+ *    queue.h) and use the PCB's sched_level and sched_ticks fields: the
+ *    process' priority level (mlfq only) and the ticks it has run since
+ *    it was last dispatched.
+ *
+ *    The idle process is scheduled like any other, except that mlfq keeps
+ *    it on the lowest level and both policies give the CPU away from it as
+ *    soon as anything else is ready.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <string.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "queue.h"
+#include "sched.h"
+#include "stats.h"
+
+/*
+ * ====================================================================
+ *    Round robin
+ * ====================================================================
+ */
+static proc_queue_t rr_queue;     // Every ready process, in FIFO order
+static int rr_quantum;            // Ticks a process runs before preemption
+
+static void rr_init(int quantum) {
+  init_queue(&rr_queue);
+  rr_quantum = quantum;
+}
+
+static void rr_make_ready(PCB_t *proc, int why) {
+  enqueue(&rr_queue, proc);
+}
+
+static PCB_t *rr_next() {
+  PCB_t *proc = dequeue(&rr_queue);
+
+  if (proc != NULL)
+    proc->sched_ticks = 0;
+
+  return proc;
+}
+
+static int rr_tick(PCB_t *curr) {
+  if (queue_count(&rr_queue) <= 0)
+    return 0;
+
+  if (curr == idle_proc)
+    return 1;
+
+  return ++curr->sched_ticks >= rr_quantum;
+}
+
+static int rr_ready_count() {
+  return queue_count(&rr_queue);
+}
+
+static sched_ops_t rr_ops = {
+  "rr", rr_init, rr_make_ready, rr_next, rr_tick, rr_ready_count
+};
+
+/*
+ * ====================================================================
+ *    Multi-level feedback queue
+ * ====================================================================
+ */
+static proc_queue_t mlfq_queues[MLFQ_LEVELS];   // Level 0 runs first
+static int mlfq_quantum[MLFQ_LEVELS];           // Ticks allowed at each level
+static unsigned int mlfq_last_boost;            // Tick of the last boost
+
+static void mlfq_init(int quantum) {
+  int i;
+
+  for (i = 0; i < MLFQ_LEVELS; i++) {
+    init_queue(mlfq_queues + i);
+    mlfq_quantum[i] = quantum << i;
+  }
+
+  mlfq_last_boost = current_tick;
+}
+
+static void mlfq_make_ready(PCB_t *proc, int why) {
+  if (proc == idle_proc) {
+    proc->sched_level = MLFQ_LEVELS - 1;
+  } else if (why == SCHED_NEW || why == SCHED_WAKE_IO) {
+    // New and interactive processes start back at the top
+    proc->sched_level = 0;
+  }
+
+  enqueue(mlfq_queues + proc->sched_level, proc);
+}
+
+static PCB_t *mlfq_next() {
+  PCB_t *proc;
+  int i;
+
+  for (i = 0; i < MLFQ_LEVELS; i++) {
+    if ((proc = dequeue(mlfq_queues + i)) != NULL) {
+      proc->sched_ticks = 0;
+      return proc;
+    }
+  }
+
+  return NULL;
+}
+
+static int mlfq_ready_count() {
+  int count = 0;
+  int i;
+
+  for (i = 0; i < MLFQ_LEVELS; i++)
+    count += queue_count(mlfq_queues + i);
+
+  return count;
+}
+
+/*
+ * Function: mlfq_boost
+ *
+ * Moves every process but idle to the top level, so long-running processes
+ * that sank to the bottom still get to run.
+ */
+static void mlfq_boost() {
+  ListNode *node;
+  PCB_t *proc;
+  int i;
+  int n;
+
+  // Ready processes move queues; idle stays at the bottom
+  for (i = 1; i < MLFQ_LEVELS; i++) {
+    for (n = queue_count(mlfq_queues + i); n > 0; n--) {
+      proc = dequeue(mlfq_queues + i);
+      if (proc == idle_proc) {
+        enqueue(mlfq_queues + i, proc);
+      } else {
+        proc->sched_level = 0;
+        enqueue(mlfq_queues, proc);
+      }
+    }
+  }
+
+  // Running and blocked processes come back at the top too
+  for (node = all_procs->first; node != NULL; node = node->next) {
+    proc = (PCB_t *) node->data;
+    if (proc != idle_proc)
+      proc->sched_level = 0;
+  }
+
+  mlfq_last_boost = current_tick;
+}
+
+static int mlfq_tick(PCB_t *curr) {
+  int expired;
+  int i;
+
+  if ((int) (current_tick - mlfq_last_boost) >= MLFQ_BOOST_TICKS)
+    mlfq_boost();
+
+  if (curr == idle_proc)
+    return mlfq_ready_count() > 0;
+
+  // A process that uses its whole quantum drops a level
+  expired = (++curr->sched_ticks >= mlfq_quantum[curr->sched_level]);
+  if (expired) {
+    curr->sched_ticks = 0;
+    if (curr->sched_level < MLFQ_LEVELS - 1)
+      curr->sched_level++;
+  }
+
+  if (mlfq_ready_count() <= 0)
+    return 0;
+
+  if (expired)
+    return 1;
+
+  // Otherwise only yield to someone at a higher priority
+  for (i = 0; i < curr->sched_level; i++) {
+    if (queue_count(mlfq_queues + i) > 0)
+      return 1;
+  }
+
+  return 0;
+}
+
+static sched_ops_t mlfq_ops = {
+  "mlfq", mlfq_init, mlfq_make_ready, mlfq_next, mlfq_tick, mlfq_ready_count
+};
+
+/*
+ * ====================================================================
+ *    Front end
+ * ====================================================================
+ */
+static sched_ops_t *sched_policies[] = { &rr_ops, &mlfq_ops, NULL };
+static sched_ops_t *sched;        // The policy in use
+
+/*
+ * Function: sched_init
+ *  @name: name of the policy to use ("rr" or "mlfq")
+ *  @quantum: base quantum in clock ticks (values below 1 mean 1)
+ *
+ * Returns SUCCESS, or ERROR if there's no policy by that name.
+ */
+int sched_init(char *name, int quantum) {
+  int i;
+
+  if (quantum < 1)
+    quantum = 1;
+
+  for (i = 0; sched_policies[i] != NULL; i++) {
+    if (strcmp(sched_policies[i]->name, name) == 0) {
+      sched = sched_policies[i];
+      sched->init(quantum);
+      TracePrintf(1, "sched_init: using the %s scheduler, quantum %d\n", name, quantum);
+      return SUCCESS;
+    }
+  }
+
+  TracePrintf(0, "sched_init: no scheduler named '%s'\n", name);
+  return ERROR;
+}
+
+/*
+ * Function: make_ready
+ *  @proc: a process that can run (and isn't on any queue)
+ *  @why: SCHED_* reason it's runnable now
+ */
+void make_ready(PCB_t *proc, int why) {
+  stats_set_state(proc, STATE_READY);
+  sched->make_ready(proc, why);
+}
+
+/*
+ * Function: sched_next
+ *
+ * Returns the process that should run next, or NULL if none are ready.
+ */
+PCB_t *sched_next() {
+  return sched->next();
+}
+
+/*
+ * Function: sched_tick
+ *  @curr: the process that was running when the clock ticked
+ *
+ * The policy decides, except that a process is never preempted when the
+ * only other ready process is idle.
+ *
+ * Returns nonzero if curr should be switched out for sched_next().
+ */
+int sched_tick(PCB_t *curr) {
+  if (!sched->tick(curr))
+    return 0;
+
+  // Switching a real process out just to run idle gains nothing
+  if (curr != idle_proc && idle_proc != NULL && idle_proc->q_on != NULL &&
+      sched->ready_count() == 1) {
+    kstats.switches_avoided++;
+    return 0;
+  }
+
+  return 1;
+}
+
+/*
+ * Function: sched_ready_count
+ *
+ * Returns the number of processes waiting to run.
+ */
+int sched_ready_count() {
+  return sched->ready_count();
+}
@@ -0,0 +1,76 @@
+/*
+ * File:  sched.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The scheduler interface. The rest of the kernel never touches a ready
+ *    queue directly: it hands runnable processes to make_ready(), asks
+ *    sched_next() who runs next, and asks sched_tick() on every clock trap
+ *    whether the current process should be preempted. Behind that sits one
+ *    of the policies below, chosen at boot with the -sched kernel option.
+ *
+ *    rr      Round robin on one FIFO queue, preempting every quantum ticks
+ *            (1 by default). This is the original Yalnix scheduler.
+ *    mlfq    Multi-level feedback queue. A process that uses up its quantum
+ *            drops a level (each level's quantum is twice the one above),
+ *            a process woken from a tty or pipe goes back to the top, and
+ *            every process is moved back to the top every MLFQ_BOOST_TICKS
+ *            ticks so nothing starves.
+ *
+ * Contents:
+ *    SCHED_*             - Reasons a process is being made ready
+ *    sched_ops_t         - The operations a policy implements
+ *    sched_init()        - Pick and initialize the policy
+ *    make_ready()        - Put a process in line to run
+ *    sched_next()        - Take the process that should run next
+ *    sched_tick()        - Account a tick; should the current process yield?
+ *    sched_ready_count() - Number of processes ready to run
+ *
+ * Warnings:
+ *    sched_next() removes the process it returns from the ready queues,
+ *    so the caller must run it (or make_ready() it again).
+ */
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+/*
+ * Public Constant Definitions
+ */
+// Reasons for make_ready()
+#define SCHED_NEW         0     // A process that hasn't run yet
+#define SCHED_PREEMPT     1     // The process was running and got switched out
+#define SCHED_WAKE        2     // Woken from a delay, wait, lock, or cvar
+#define SCHED_WAKE_IO     3     // Woken from a tty or pipe (interactive)
+
+// Multi-level feedback queue tuning
+#define MLFQ_LEVELS       3     // Number of priority levels
+#define MLFQ_BOOST_TICKS  50    // Ticks between moving everyone to the top
+
+/*
+ * sched_ops_t datatype
+ *
+ * A scheduling policy.
+ */
+struct PCB_t;
+
+typedef struct sched_ops_t {
+  char *name;                                       // Name given to -sched
+  void (*init)(int quantum);                        // Set up empty ready queues
+  void (*make_ready)(struct PCB_t *proc, int why);  // Queue a runnable process
+  struct PCB_t *(*next)();                          // Dequeue who runs next
+  int (*tick)(struct PCB_t *curr);                  // Nonzero to preempt curr
+  int (*ready_count)();                             // Processes ready to run
+} sched_ops_t;
+
+/*
+ * Public Prototypes
+ */
+int sched_init(char *name, int quantum);
+void make_ready(struct PCB_t *proc, int why);
+struct PCB_t *sched_next();
+int sched_tick(struct PCB_t *curr);
+int sched_ready_count();
+
+#endif // _SCHED_H_
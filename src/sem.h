@@ -0,0 +1,22 @@
+/*
+ * File: sem.h
+ *  Carter J. Bastian, KC Beard
+ *  CS58 15F
+ */
+
+#ifndef _SEM_H_
+#define _SEM_H_
+#include "queue.h"
+
+/*
+ * A counting semaphore. SemUp hands its unit straight to the process at
+ * the head of waiters when there is one, so value only counts units
+ * nobody has claimed yet and a woken process never has to re-check it.
+ */
+typedef struct SEM_t {
+  int id;
+  int value;                // Units available; 0 whenever anyone waits
+  proc_queue_t waiters;     // Processes blocked in SemDown, oldest first
+} SEM_t;
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * File: slab.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the object caches declared in slab.h. A cache
+ *    grows by one slab whenever its free list is empty: the slab is
+ *    malloc'd in one piece and every object in it is pushed onto the free
+ *    list. Caches register themselves on their first slab so slab_stats()
+ *    can find them.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *    Nothing checks that an object handed to slab_free() came from that
+ *    cache, or that it isn't already free.
+ */
+
+/* System Includes */
+#include <string.h>
+#include <stdlib.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "slab.h"
+
+/*
+ * Private Variables
+ */
+static slab_cache_t *slab_caches[SLAB_MAX_CACHES];   // Every cache with a slab
+static int slab_ncaches = 0;
+
+/*
+ * Private Prototypes
+ */
+static int slab_grow(slab_cache_t *cache);
+
+/*
+ * Function: slab_grow
+ *  @cache: a cache whose free list is empty
+ *
+ * Carves a new slab into free objects, setting up the cache first if
+ * this is its first slab.
+ *
+ * Returns SUCCESS, or ERROR if the kernel heap ran out.
+ */
+static int slab_grow(slab_cache_t *cache) {
+  char *slab;
+  unsigned int i;
+
+  if (cache->stats.slabs == 0) {
+    cache->obj_size = (cache->size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    if (cache->obj_size < sizeof(void *))
+      cache->obj_size = sizeof(void *);
+
+    cache->per_slab = SLAB_BYTES / cache->obj_size;
+    if (cache->per_slab < SLAB_MIN_OBJS)
+      cache->per_slab = SLAB_MIN_OBJS;
+
+    strncpy(cache->stats.name, cache->name, SLAB_NAME_LEN - 1);
+    cache->stats.obj_size = cache->obj_size;
+    cache->stats.per_slab = cache->per_slab;
+
+    if (slab_ncaches < SLAB_MAX_CACHES)
+      slab_caches[slab_ncaches++] = cache;
+  }
+
+  slab = (char *) malloc(cache->per_slab * cache->obj_size);
+  if (slab == NULL) {
+    TracePrintf(3, "slab_grow: out of kernel heap for the %s cache\n", cache->name);
+    return ERROR;
+  }
+
+  // Push them in reverse so the slab is handed out front to back
+  for (i = cache->per_slab; i > 0; i--) {
+    *((void **) (slab + (i - 1) * cache->obj_size)) = cache->free_list;
+    cache->free_list = (void *) (slab + (i - 1) * cache->obj_size);
+  }
+
+  cache->stats.slabs++;
+
+  return SUCCESS;
+}
+
+/*
+ * Function: slab_alloc
+ *  @cache: the cache to allocate from
+ *
+ * Returns a zeroed object of the cache's size, or NULL if the kernel heap
+ * ran out.
+ */
+void *slab_alloc(slab_cache_t *cache) {
+  void *obj;
+
+  if (cache->free_list == NULL && slab_grow(cache) != SUCCESS)
+    return NULL;
+
+  obj = cache->free_list;
+  cache->free_list = *((void **) obj);
+  bzero((char *) obj, cache->size);
+
+  cache->stats.allocs++;
+  cache->stats.in_use++;
+  if (cache->stats.in_use > cache->stats.peak)
+    cache->stats.peak = cache->stats.in_use;
+
+  return obj;
+}
+
+/*
+ * Function: slab_free
+ *  @cache: the cache obj came from
+ *  @obj: an object from slab_alloc(cache), or NULL
+ */
+void slab_free(slab_cache_t *cache, void *obj) {
+  if (obj == NULL)
+    return;
+
+  *((void **) obj) = cache->free_list;
+  cache->free_list = obj;
+
+  cache->stats.frees++;
+  cache->stats.in_use--;
+}
+
+/*
+ * Function: slab_stats
+ *  @idx: which cache, counting from 0 in the order they were first used
+ *  @ss: where to copy its counters
+ *
+ * Returns SUCCESS, or ERROR if there's no cache with that index.
+ */
+int slab_stats(int idx, slabstats_t *ss) {
+  if (idx < 0 || idx >= slab_ncaches)
+    return ERROR;
+
+  *ss = slab_caches[idx]->stats;
+
+  return SUCCESS;
+}
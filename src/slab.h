@@ -0,0 +1,72 @@
+/*
+ * File:  slab.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Object caches for the kernel's fixed-size structures. Each cache hands
+ *    out objects of one size, carved from slabs of SLAB_BYTES taken from
+ *    the kernel heap, and keeps the objects that are given back on a free
+ *    list. Allocating or freeing an object is a couple of pointer moves,
+ *    objects of one type sit next to each other, and the malloc heap only
+ *    sees a few big slab-sized blocks instead of a stream of small ones.
+ *
+ *    A cache is declared with its name and object size and needs no other
+ *    setup; it gets its first slab the first time it's used:
+ *
+ *        static slab_cache_t lock_cache = SLAB_CACHE("lock", sizeof(LOCK_t));
+ *
+ *        LOCK_t *lock = (LOCK_t *) slab_alloc(&lock_cache);
+ *        ...
+ *        slab_free(&lock_cache, lock);
+ *
+ * Contents:
+ *    slab_cache_t        - An object cache
+ *    SLAB_CACHE()        - Initializer for a cache
+ *    slab_alloc()        - Get a zeroed object
+ *    slab_free()         - Give an object back
+ *    slab_stats()        - Copy out the counters of a cache
+ *
+ * Warnings:
+ *    Slabs are never given back to malloc, so a cache stays as big as it
+ *    has ever been. Objects must be given back to the cache they came from.
+ */
+
+#ifndef _SLAB_H_
+#define _SLAB_H_
+
+#include "stats.h"
+
+/*
+ * Public Constant Definitions
+ */
+#define SLAB_BYTES        4096    // Size of a slab, unless that's < SLAB_MIN_OBJS objects
+#define SLAB_MIN_OBJS     4       // Fewest objects in a slab
+#define SLAB_ALIGN        8       // Objects are rounded up to a multiple of this
+#define SLAB_MAX_CACHES   16      // Caches slab_stats() can report on
+
+/*
+ * slab_cache_t datatype
+ *
+ * Only name and size are set by SLAB_CACHE(); the rest is filled in the
+ * first time the cache is used.
+ */
+typedef struct slab_cache_t {
+  char *name;
+  unsigned int size;            // Bytes asked for in each object
+  unsigned int obj_size;        // size rounded up to SLAB_ALIGN
+  unsigned int per_slab;        // Objects carved from each slab
+  void *free_list;              // Free objects, linked through their first word
+  slabstats_t stats;            // Counters (see stats.h)
+} slab_cache_t;
+
+#define SLAB_CACHE(name, size)  { (name), (size) }
+
+/*
+ * Public Prototypes
+ */
+void *slab_alloc(slab_cache_t *cache);
+void slab_free(slab_cache_t *cache, void *obj);
+int slab_stats(int idx, slabstats_t *ss);
+
+#endif // _SLAB_H_
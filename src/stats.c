@@ -0,0 +1,186 @@
+/*
+ * File: stats.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Updates the performance counters declared in stats.h and implements
+ *    the stats syscall. Time in each state is accounted when a process
+ *    changes state (not on every clock tick), so keeping per-process tick
+ *    counts costs nothing for processes that are just sitting blocked.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <string.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "syscalls.h"
+#include "stats.h"
+#include "tty.h"
+#include "slab.h"
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: stats_set_state
+ *  @proc: a process changing state
+ *  @state: the STATE_* it's entering
+ *
+ * Charges the ticks since the process' last change to its old state.
+ */
+void stats_set_state(PCB_t *proc, int state) {
+  proc->stats.ticks[proc->stat_state] += current_tick - proc->stat_since;
+  proc->stat_state = state;
+  proc->stat_since = current_tick;
+}
+
+/*
+ * Function: stats_switch
+ *  @curr: the process being switched out, or NULL if it exited
+ *  @next: the process being switched to
+ *
+ * A process that's switched out after being made ready was preempted;
+ * one that's still marked running is blocking.
+ */
+void stats_switch(PCB_t *curr, PCB_t *next) {
+  if (curr != NULL) {
+    if (curr->stat_state == STATE_READY) {
+      curr->stats.switches_involuntary++;
+      kstats.switches_involuntary++;
+    } else {
+      curr->stats.switches_voluntary++;
+      kstats.switches_voluntary++;
+      stats_set_state(curr, STATE_BLOCKED);
+    }
+  }
+
+  stats_set_state(next, STATE_RUNNING);
+}
+
+/*
+ * Function: stats_syscall
+ *  @proc: the process making the syscall
+ *  @code: the syscall code from the UserContext
+ */
+void stats_syscall(PCB_t *proc, unsigned int code) {
+  kstats.syscalls[STATS_SYSCALL_INDEX(code)]++;
+  proc->stats.syscalls++;
+}
+
+/*
+ * Function: stats_fault
+ *  @proc: the process that faulted
+ *  @kind: FAULT_* kind of the fault
+ */
+void stats_fault(PCB_t *proc, int kind) {
+  kstats.faults[kind]++;
+  proc->stats.faults[kind]++;
+}
+
+/*
+ * Function: stats_pipe
+ *  @proc: the process reading or writing
+ *  @bytes_in: bytes read from a pipe
+ *  @bytes_out: bytes written to a pipe
+ */
+void stats_pipe(PCB_t *proc, int bytes_in, int bytes_out) {
+  kstats.pipe_bytes_in += bytes_in;
+  kstats.pipe_bytes_out += bytes_out;
+  proc->stats.pipe_bytes_in += bytes_in;
+  proc->stats.pipe_bytes_out += bytes_out;
+}
+
+/*
+ * Function: stats_tty
+ *  @proc: the process reading or writing
+ *  @bytes_in: bytes read from a terminal
+ *  @bytes_out: bytes written to a terminal
+ */
+void stats_tty(PCB_t *proc, int bytes_in, int bytes_out) {
+  kstats.tty_bytes_in += bytes_in;
+  kstats.tty_bytes_out += bytes_out;
+  proc->stats.tty_bytes_in += bytes_in;
+  proc->stats.tty_bytes_out += bytes_out;
+}
+
+/*
+ * Function: stats_size
+ *  @which: a STATS_* selector
+ *
+ * Returns the size of the buffer the selector copies out, or ERROR if the
+ * selector isn't recognized.
+ */
+int stats_size(int which) {
+  switch (which) {
+    case STATS_KERNEL:
+      return sizeof(kstats_t);
+    case STATS_PROC:
+      return sizeof(pstats_t);
+    case STATS_TTY:
+      return sizeof(ttystats_t);
+    case STATS_SLAB:
+      return sizeof(slabstats_t);
+    default:
+      return ERROR;
+  }
+}
+
+/*
+ * Function: Yalnix_Stats
+ *  @which: STATS_KERNEL, STATS_PROC, STATS_TTY, or STATS_SLAB
+ *  @buf: user buffer of stats_size(which) bytes, already validated
+ *  @pid: for STATS_PROC, the process to report on (-1 for the caller);
+ *        for STATS_TTY, the terminal; for STATS_SLAB, the cache index
+ *
+ * Returns SUCCESS, or ERROR on an unknown selector, pid, terminal, or
+ * cache.
+ */
+int Yalnix_Stats(int which, void *buf, int pid) {
+  ListNode *node;
+  PCB_t *proc;
+  pstats_t ps;
+
+  switch (which) {
+    case STATS_KERNEL:
+      kstats.ticks = current_tick;
+      kstats.frames_free = frames_available();
+      memcpy(buf, (void *) &kstats, sizeof(kstats_t));
+      return SUCCESS;
+
+    case STATS_PROC:
+      if (pid == -1) {
+        proc = curr_proc;
+      } else {
+        if ((node = find_by_id(all_procs, pid)) == NULL)
+          return ERROR;
+        proc = (PCB_t *) node->data;
+      }
+
+      // Include the time spent in the current state so far
+      ps = proc->stats;
+      ps.pid = proc->proc_id;
+      ps.ticks[proc->stat_state] += current_tick - proc->stat_since;
+      memcpy(buf, (void *) &ps, sizeof(pstats_t));
+      return SUCCESS;
+
+    case STATS_TTY:
+      return tty_stats(pid, (ttystats_t *) buf);
+
+    case STATS_SLAB:
+      return slab_stats(pid, (slabstats_t *) buf);
+
+    default:
+      return ERROR;
+  }
+}
@@ -0,0 +1,177 @@
+/*
+ * File:  stats.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Kernel performance counters. The kernel keeps one kstats_t for the
+ *    whole system and one pstats_t in every PCB, and user programs read
+ *    them with the stats syscall:
+ *
+ *        kstats_t ks;
+ *        Custom0(STATS_KERNEL, (int) &ks, 0, 0);
+ *
+ *        pstats_t ps;
+ *        Custom0(STATS_PROC, (int) &ps, pid, 0);   // pid -1 for yourself
+ *
+ *        ttystats_t ts;
+ *        Custom0(STATS_TTY, (int) &ts, tty_id, 0);
+ *
+ *        slabstats_t ss;
+ *        Custom0(STATS_SLAB, (int) &ss, i, 0);    // i = 0, 1, ... until ERROR
+ *
+ *    Custom0 returns 0 on success and ERROR on a bad selector, buffer,
+ *    pid, terminal, or cache. This header has no kernel dependencies so
+ *    that user programs can include it too.
+ *
+ * Contents:
+ *    STATS_*             - Stats syscall selectors and sizes
+ *    pstats_t            - Per-process counters
+ *    kstats_t            - Kernel-wide counters
+ *    ttystats_t          - Per-terminal counters
+ *    slabstats_t         - Per-object-cache counters
+ *    stats_*()           - Kernel-side hooks that update the counters
+ *
+ * Warnings:
+ *    Counters are unsigned ints and wrap silently.
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+/*
+ * Public Constant Definitions
+ */
+// Stats syscall (YALNIX_CUSTOM_0) selectors
+#define YALNIX_STATS      YALNIX_CUSTOM_0
+#define STATS_KERNEL      0     // Copy out the kstats_t
+#define STATS_PROC        1     // Copy out the pstats_t of one process
+#define STATS_TTY         2     // Copy out the ttystats_t of one terminal
+#define STATS_SLAB        3     // Copy out the slabstats_t of one object cache
+
+#define SLAB_NAME_LEN     16
+
+// Syscalls are counted by the low bits of their code
+#define STATS_SYSCALLS    128
+#define STATS_SYSCALL_INDEX(code)   ((code) & (STATS_SYSCALLS - 1))
+
+// Process states for tick accounting
+#define STATE_RUNNING     0
+#define STATE_READY       1
+#define STATE_BLOCKED     2
+#define STATE_COUNT       3
+
+// Page fault kinds
+#define FAULT_COW         0     // Write to a copy-on-write page
+#define FAULT_LAZY        1     // First touch of a demand-paged page
+#define FAULT_STACK       2     // Stack growth
+#define FAULT_FATAL       3     // Any fault that killed the process
+#define FAULT_COUNT       4
+
+// TLB flush kinds
+#define FLUSH_ALL         0
+#define FLUSH_REGION_0    1
+#define FLUSH_REGION_1    2
+#define FLUSH_PAGE        3
+#define FLUSH_COUNT       4
+
+/*
+ * pstats_t datatype
+ *
+ * Counters kept for a single process.
+ */
+typedef struct pstats_t {
+  unsigned int pid;
+  unsigned int switches_voluntary;      // Switched out because it blocked
+  unsigned int switches_involuntary;    // Switched out by the scheduler
+  unsigned int ticks[STATE_COUNT];      // Clock ticks spent in each state
+  unsigned int syscalls;                // Syscalls made
+  unsigned int faults[FAULT_COUNT];     // Page faults by kind
+  unsigned int pipe_bytes_in;           // Bytes read from pipes
+  unsigned int pipe_bytes_out;          // Bytes written to pipes
+  unsigned int tty_bytes_in;            // Bytes read from terminals
+  unsigned int tty_bytes_out;           // Bytes written to terminals
+} pstats_t;
+
+/*
+ * kstats_t datatype
+ *
+ * Counters kept for the whole kernel.
+ */
+typedef struct kstats_t {
+  unsigned int ticks;                       // Clock traps since boot
+  unsigned int idle_ticks;                  // Of those, ticks spent in idle
+  unsigned int switches_voluntary;
+  unsigned int switches_involuntary;
+  unsigned int switches_avoided;            // Reschedules that kept the process
+  unsigned int syscalls[STATS_SYSCALLS];    // By STATS_SYSCALL_INDEX(code)
+  unsigned int faults[FAULT_COUNT];
+  unsigned int frames_allocated;
+  unsigned int frames_freed;
+  unsigned int frames_free;                 // Filled in when read
+  unsigned int tlb_flushes[FLUSH_COUNT];
+  unsigned int tlb_flushes_saved;           // Region flushes done page by page
+  unsigned int pipe_bytes_in;
+  unsigned int pipe_bytes_out;
+  unsigned int tty_bytes_in;
+  unsigned int tty_bytes_out;
+  unsigned int disk_reads;                  // DiskAccess calls of each kind
+  unsigned int disk_writes;
+  unsigned int disk_merged;                 // Requests served by another's access
+  unsigned int disk_seek;                   // Sectors the head has moved
+  unsigned int bcache_hits;                 // Sector lookups found in the cache
+  unsigned int bcache_misses;
+  unsigned int bcache_writebacks;           // Dirty sectors written to the disk
+} kstats_t;
+
+/*
+ * ttystats_t datatype
+ *
+ * Counters kept for each terminal. The queue depths are filled in when
+ * they're read.
+ */
+typedef struct ttystats_t {
+  unsigned int tty_id;
+  unsigned int bytes_in;                // Bytes received from the terminal
+  unsigned int bytes_out;               // Bytes transmitted to it
+  unsigned int bytes_dropped;           // Input lost because the ring was full
+  unsigned int transmits;               // TtyTransmit calls
+  unsigned int tx_ticks;                // Clock ticks those took, in all
+  unsigned int tx_max_ticks;            // Longest a single transmit took
+  unsigned int out_queued;              // Bytes waiting to be transmitted
+  unsigned int out_queued_max;          // Most that have ever been waiting
+  unsigned int in_queued;               // Bytes of input waiting to be read
+  unsigned int readers;                 // Processes blocked in TtyRead
+  unsigned int writers;                 // Processes blocked in TtyWrite
+} ttystats_t;
+
+/*
+ * slabstats_t datatype
+ *
+ * Counters kept for each kernel object cache (see slab.h).
+ */
+typedef struct slabstats_t {
+  char name[SLAB_NAME_LEN];
+  unsigned int obj_size;                // Bytes per object, after alignment
+  unsigned int per_slab;                // Objects in each slab
+  unsigned int slabs;                   // Slabs taken from the kernel heap
+  unsigned int in_use;                  // Objects currently allocated
+  unsigned int peak;                    // Most ever allocated at once
+  unsigned int allocs;
+  unsigned int frees;
+} slabstats_t;
+
+/*
+ * Kernel Prototypes
+ */
+struct PCB_t;
+
+void stats_set_state(struct PCB_t *proc, int state);
+void stats_switch(struct PCB_t *curr, struct PCB_t *next);
+void stats_syscall(struct PCB_t *proc, unsigned int code);
+void stats_fault(struct PCB_t *proc, int kind);
+void stats_pipe(struct PCB_t *proc, int bytes_in, int bytes_out);
+void stats_tty(struct PCB_t *proc, int bytes_in, int bytes_out);
+int stats_size(int which);
+
+#endif // _STATS_H_
@@ -3,9 +3,11 @@
  */
 #include <hardware.h>
 #include <string.h>
+#include <unistd.h>
 #include "tty.h"
 #include "cvar.h"
 #include "lock.h"
+#include "sem.h"
 
 /*
  * Local Includes
@@ -15,6 +17,32 @@
 #include "syscalls.h"
 #include "blocks.h"
 #include "pipe.h"
+#include "slab.h"
+
+/*
+ * Private Variables
+ */
+static slab_cache_t lock_cache = SLAB_CACHE("lock", sizeof(LOCK_t));
+static slab_cache_t cvar_cache = SLAB_CACHE("cvar", sizeof(CVAR_t));
+static slab_cache_t sem_cache = SLAB_CACHE("sem", sizeof(SEM_t));
+static slab_cache_t pipe_cache = SLAB_CACHE("pipe", sizeof(pipe_t));
+
+/*
+ * Function: last_user_proc
+ *  @proc: a process that's exiting
+ *
+ * Returns 1 if every other live process is idle, 0 otherwise.
+ */
+static int last_user_proc(PCB_t *proc) {
+  ListNode *node;
+
+  for (node = all_procs->first; node != NULL; node = node->next) {
+    if (node->data != (void *) proc && node->data != (void *) idle_proc)
+      return 0;
+  }
+
+  return 1;
+}
 
 /*
  * Function: Yalnix_Wait
@@ -101,11 +129,10 @@ int Yalnix_Wait(int *status_ptr, UserContext *uc) {
   // The obj_ptr field gets a pointer to the blocking process
   parent->block->obj_ptr = (void *)parent;
 
-  /* Update Kernel globals */
-  add_to_list(blocked_procs, parent, parent->proc_id);
+  /* Exit wakes us when a child's status shows up in exited_children */
 
   /* Switch to the next avaialble process */
-  if (count_items(ready_procs) <= 0) {
+  if (sched_ready_count() <= 0) {
       TracePrintf(3, "No Items on the ready queue to switch to.\n");
       exit(ERROR);
   } else {
@@ -192,10 +219,21 @@ void Yalnix_Exit(int status, UserContext *uc) {
 
   ListNode *iterator;             // For iterating through lists
   ListNode *temp_node;            // For storing info returned from lists
+  proc_queue_t skipped;           // Ready procs that can't be run from here
+  tlb_batch_t batch;              // Region 1 pages unmapped
 
   int i;                          // Reusable loop iterator
 
 
+  /*
+   * Write the buffer cache back when init or the last user process exits.
+   * This has to happen while the process can still block on the disk
+   * (idle runs meanwhile), not on the way to halting the machine.
+   */
+  if (curr_proc->parent == idle_proc || last_user_proc(curr_proc))
+    bcache_sync();
+
+
   /*
    * Validate Input and store exit information
    */
@@ -214,7 +252,8 @@ void Yalnix_Exit(int status, UserContext *uc) {
   has_parent = ((proc->parent == NULL) ? 0 : 1);
 
   // Are we exiting the root process (init) with nothing to take its place?
-  if (pid == 0 && (count_items(ready_procs) <= 0)) {
+  if (pid == 0 && (sched_ready_count() <= 0)) {
+    // The buffer cache was written back above; nothing can block here
     TracePrintf(3, "\t===>\n\tHALTING MACHINE: About to halt machine by exiting init\n");
     exit(SUCCESS);
   }
@@ -282,9 +321,16 @@ void Yalnix_Exit(int status, UserContext *uc) {
     }
 
     add_to_list(parent->exited_children, (void *)NULL, pid);
+
+    // Wake the parent if it's blocked in Wait
+    if (parent->block->active == BLOCK_ACTIVE && parent->block->type == WAIT_BLOCK)
+      wake_proc(parent);
   }
 
 
+  /* Fail anyone blocked sending to or receiving from us */
+  ipc_exit(proc);
+
   /* Move self from all_procs to dead_procs */
   if (remove_from_list(all_procs, (void *)proc) != 0)
     TracePrintf(3, "Failed to remove exiting proc from global list of all procs\n");
@@ -301,26 +347,27 @@ void Yalnix_Exit(int status, UserContext *uc) {
     if ( (*(proc->region0_pt + i)).valid == 0x1 ) {
       // Set it to invalid, free the physical frame, and reset the pfn
       (*(proc->region0_pt + i)).valid = (u_long) 0x0;
-      add_to_list(&FrameList, (void *)NULL, PFN_TO_FNUM( (*(proc->region0_pt + i)).pfn ));
+      free_frame(PFN_TO_FNUM( (*(proc->region0_pt + i)).pfn ));
       (*(proc->region0_pt + i)).pfn = (u_long) 0x0;
     }
   }
 
-  /* Deallocate frames in Region 1 */
+  /* Deallocate frames in Region 1 (shared COW frames just lose a reference) */
+  tlb_batch_init(&batch);
   for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
     if ( (*(proc->region1_pt + i)).valid == 0x1 ) {
       // Set it to invalid, free the physical frame, and reset the pfn
-      (*(proc->region1_pt + i)).valid = (u_long) 0x0;
-      add_to_list(&FrameList, (void *)NULL, PFN_TO_FNUM( (*(proc->region1_pt + i)).pfn ));
-      (*(proc->region1_pt + i)).pfn = (u_long) 0x0;
+      free_frame(PFN_TO_FNUM( (*(proc->region1_pt + i)).pfn ));
+      tlb_set_pte(&batch, proc->region1_pt + i, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+          (u_long) 0x0, (*(proc->region1_pt + i)).prot, (u_long) 0x0);
     }
   }
 
   /* 
-   * I'm scared of flushing this. Are any of the variables in THIS function in
-   * the kernel stack that will be lost or changed?
+   * Only region 1 changed (the kernel stack above is this process' saved
+   * copy, not the live r0_pagetable), so region 0 can stay in the TLB.
    */
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  tlb_batch_flush(&batch);
 
 
   /*
@@ -332,32 +379,27 @@ void Yalnix_Exit(int status, UserContext *uc) {
   if (has_exited_kids)
     free(proc->exited_children);
 
-  // Free Pointers to Page Tables
-  free(proc->region1_pt);
-  free(proc->region0_pt);
+  // Close the executable we were demand paging from
+  if (proc->exec_fd >= 0)
+    close(proc->exec_fd);
 
-  // Free Pointers to UserContext and KernelContext
-  free(proc->uc);
-  free(proc->kc_p);
+  // Let go of the shared text (freed here if we were its last user)
+  text_release(proc->text);
 
-  // Free Pointer to the Process Control Block itself
-  free(proc);
+  // Free the page tables, contexts, and the Process Control Block itself
+  free_process(proc);
 
   /*
    * Move on to Next Process
    */
   // Get the next available process
-  ListNode *next_node = pop(ready_procs);
-  next = (PCB_t *) next_node->data;
-  free(next_node);
-  
   // Ensure that we don't run a brand new (uninitialized) proc out of Exit call
-  while (next->kc_set == 0) {
-    add_to_list(ready_procs, (void *) next, next->proc_id);
-    next_node = pop(ready_procs);
-    next = (PCB_t *) next_node->data;
-    free(next_node);
-  }
+  init_queue(&skipped);
+  while ((next = sched_next())->kc_set == 0)
+    enqueue(&skipped, next);
+
+  while ((child = dequeue(&skipped)) != NULL)
+    make_ready(child, SCHED_PREEMPT);
 
   TracePrintf(1, "End: Yalnix_Exit\n");
 
@@ -391,18 +433,13 @@ int Yalnix_Fork(UserContext *uc) {
   PCB_t *parent;                    // Process Control Block of the parent
   unsigned int child_pid;           // Process ID of the child process
 
-  int pfn_temp;                     // A variable to hold the pfn most recently
-                                    // popped from FrameList
+  int fnum_temp;                    // A variable to hold the frame most recently
+                                    // taken from the frame allocator
 
-  int dest_page;                    // Page in r0 for mapping a frame from child
-                                    // process to a page currently in memory
-  int dest_old_pfn;                 // pfn of dest_page before being mapped elsewhere
-  int dest_old_valid;               // validity of dest_page before being mapped
-  unsigned int dest;                // Address to copy to
+  void *dest;                       // Child's frame, mapped at the scratch page
   unsigned int src;                 // Address to copy from
   int retval;                       // Return value
   int i;                            // Iterator for loops
-  ListNode *node;
 
 
   /* Store the the UserContext of the parent process */  
@@ -415,16 +452,26 @@ int Yalnix_Fork(UserContext *uc) {
 
   // Create a new Process Controll Block shell for the child
   child = new_process(parent->uc);
+  if (child == NULL) {
+    return(ERROR);
+  }
 
   // Copy the user context completely into the child
   memcpy((void *) child->uc, (void *) parent->uc, sizeof(UserContext));
 
-  // Dynamically allocate space for child's kernel stack and region 1 PTEs
-  child->region0_pt = (struct pte *) malloc(KS_NPG * sizeof(struct pte));
-  child->region1_pt = (struct pte *) malloc(VMEM_1_PAGE_COUNT * sizeof(struct pte));
-  
-  if (child->region0_pt == NULL || child->region1_pt == NULL) {
+  // Allocate space for child's kernel stack and region 1 PTEs
+  if (alloc_page_tables(child) != SUCCESS) {
     TracePrintf(3, "Failed to allocate kernel space for child process' pagetables\n");
+    free_process(child);
+    return(ERROR);
+  }
+
+  // The kernel stack is the only thing copied eagerly, so it's the only
+  // thing we need frames for right now. Check before the child takes a
+  // descriptor or a text reference.
+  if (frames_available() < KS_NPG) {
+    TracePrintf(1, "Not enough frames for child process' kernel stack\n");
+    free_process(child);
     return(ERROR);
   }
 
@@ -432,119 +479,50 @@ int Yalnix_Fork(UserContext *uc) {
   child->heap_base_page = parent->heap_base_page;
   child->brk_addr = parent->brk_addr;
 
+  // The child pages in its own copy of any still-lazy pages
+  child->data_end = parent->data_end;
+  if (parent->exec_fd >= 0)
+    child->exec_fd = dup(parent->exec_fd);
+
+  // The child runs the same shared text (its frames are referenced below)
+  child->text = parent->text;
+  text_dup(child->text);
+
 
   /* 
    * Create the PageTables for the child process 
    */
   TracePrintf(1, "Creating the Page Table Mappings\n");
-  // First copy the pagetables exactly for permissions and validity
+  // First copy the kernel stack pagetable exactly for permissions and validity
   memcpy((void *) child->region0_pt, 
       (void *) parent->region0_pt, 
       (KS_NPG * sizeof(struct pte)) );
 
-  memcpy((void *) child->region1_pt,
-      (void *) parent->region1_pt,
-      (VMEM_1_PAGE_COUNT * sizeof(struct pte)) );
-
-
   // Allocate new physical frames for each page in the kernel stack
   for (i = 0; i < KS_NPG; i++) {
-    /* 
-     * WARNING: this code is inefficient. Figure out a way to remove calls to
-     * count_items
-     */
-    if (count_items(&FrameList) <= 0) {
-      TracePrintf(1, "Not enough frames for child process' kernel stack\n");
-      return(ERROR);
-    }
-    node = pop(&FrameList);
-    pfn_temp = node->id;
-    free(node);
-    (*(child->region0_pt + i)).pfn = FNUM_TO_PFN(pfn_temp);
+    fnum_temp = alloc_frame();
+    (*(child->region0_pt + i)).pfn = FNUM_TO_PFN(fnum_temp);
   }
 
-  // Allocate new physical frames for each valid page in region 1
-  for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
-    // Is this a valid page in region 1?
-    if ( (*(child->region1_pt + i)).valid == (u_long) 0x1) {
-      // If so give it a new physical frame
-
-      /* WARNING: see warning above on inefficiency */
-      if (count_items(&FrameList) <= 0) {
-        TracePrintf(1, "Not enough frames for child process' region 1\n");
-        return(ERROR);
-      }
-      node = pop(&FrameList);
-      pfn_temp = node->id;
-      free(node);
-      (*(child->region1_pt + i)).pfn = FNUM_TO_PFN(pfn_temp);
-    
-    } else {
-      // If not, ensure its pfn is 0
-      (*(child->region1_pt + i)).pfn = (u_long) 0x0;
-    }
-  }
-  TracePrintf(1, "Finished Allocating Frames\n");
+  // Region 1 is shared copy-on-write: the child maps the parent's frames
+  // read-only and pages are copied the first time either process writes
+  cow_share_pages(parent, child);
+  TracePrintf(1, "Finished Sharing Region 1 Copy-On-Write\n");
 
   /* 
-   * Manually Copy all of the contents of the parent's memory into
-   *   child process
+   * Copy the parent's kernel stack into the child's frames, one page at
+   *   a time through the scratch page
    */
-  // Set up a mapping to the page direclty beneath the ks for mapping
-  dest_page = (KERNEL_STACK_BASE >> PAGESHIFT) - 1;
-  
-  // Store old settings of that entry in the page table
-  dest_old_pfn = r0_pagetable[dest_page].pfn;
-  dest_old_valid = r0_pagetable[dest_page].valid;
-
-  // Make the destination page valid
-  r0_pagetable[dest_page].valid = (u_long) 0x1;
-
-  // The dest is the virtual address of the dest_page in memory
-  dest = dest_page << PAGESHIFT;
-  
-  
   TracePrintf(1, "About to copy kernel pages\n");
-  // Loop through the pages in the kernel stack, copying each to the dest page
   for (i = 0; i < KS_NPG; i++) {
     // The src is the virtual address of this page of the kernel stack
     src = KERNEL_STACK_BASE + (i * PAGESIZE);
 
-    // Set up the destination page to have the pfn of corresponding page in
-    // child proc's page table
-    r0_pagetable[dest_page].pfn = (*(child->region0_pt + i)).pfn;
-    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
-
-    // Copy the memory contents from the parent's frame for the page to the
-    // child's frame for the page (aka dest)
-    memcpy((void *) dest, (void *) src, PAGESIZE);
-  }
-
-  TracePrintf(1, "About to copy Region 1 Pages\n");
-  // Loop through the pages in region 1, copying each valid page to dest
-  for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
-    // Only copy this if it's a valid page in memory for the parent
-    if ( (*(child->region1_pt + i)).valid == 0x1 ) {
-      // The src is the virtual address in memory of the page in r1
-      src = VMEM_1_BASE + (i * PAGESIZE);
-
-      // Set up destination page for have pfn for page in child proc's region1
-      // page table.
-      r0_pagetable[dest_page].pfn = (*(child->region1_pt + i)).pfn;
-      WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
-
-      // Copy the memory contents from the parent's frame for the page to the
-      // child's frame for page (aka dest)
-      memcpy((void *)dest, (void *) src, PAGESIZE);
-    }
+    dest = map_scratch_frame(PFN_TO_FNUM((*(child->region0_pt + i)).pfn));
+    memcpy(dest, (void *) src, PAGESIZE);
+    unmap_scratch_frame();
   }
 
-  TracePrintf(1, "About to restore the PTE for the destination page\n");
-  // Restore old PTE for destination page
-  r0_pagetable[dest_page].valid = dest_old_valid;
-  r0_pagetable[dest_page].pfn = dest_old_pfn;
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
-
 
   /*
    * Kernel Bookkeeping
@@ -561,7 +539,7 @@ int Yalnix_Fork(UserContext *uc) {
 
   // Update the kernel queues
   add_to_list(all_procs, (void *)child, child->proc_id);
-  add_to_list(ready_procs, (void *)parent, parent->proc_id);
+  make_ready(parent, SCHED_PREEMPT);
 
 
   /*
@@ -623,6 +601,7 @@ int Yalnix_Exec(UserContext *uc) {
   int i;                      // Iterator variable for loops
   int len;                    // A length variable for string size counting
   int rc;                     // Return code variable
+  tlb_batch_t batch;          // Region 1 pages unmapped
   /*
    * Parse the filename, argc, argv[] arguments.
    */
@@ -705,31 +684,41 @@ int Yalnix_Exec(UserContext *uc) {
   /*
    * Trash the old Region 1 and reinitialize it to be blank
    */
+  tlb_batch_init(&batch);
   for (i = 0; i < VMEM_1_PAGE_COUNT; i++) {
     if ( (*(proc->region1_pt + i)).valid == 0x1) {
-      // Put old frame back onto the frame list
-      add_to_list(&FrameList, (void *) NULL, PFN_TO_FNUM( (*(proc->region1_pt + i)).pfn ));
+      // Give the old frame back to the frame allocator
+      free_frame(PFN_TO_FNUM( (*(proc->region1_pt + i)).pfn ));
       // Reset pte to defaults (defaults for protections should still apply)
-      (*(proc->region1_pt + i)).pfn = (u_long) 0x0;
-      (*(proc->region1_pt + i)).valid = (u_long) 0x0;
+      tlb_set_pte(&batch, proc->region1_pt + i, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+          (u_long) 0x0, (*(proc->region1_pt + i)).prot, (u_long) 0x0);
     }
   }
 
+  // None of the old pages' software state applies to the new program
+  bzero((void *)proc->region1_info, VMEM_1_PAGE_COUNT * sizeof(page_info_t));
+  forget_user_ranges(proc);
+  if (proc->exec_fd >= 0) {
+    close(proc->exec_fd);
+    proc->exec_fd = -1;
+  }
+  text_release(proc->text);
+  proc->text = NULL;
+
 
   /*
    * Trash the old kernel stack and reinitialize it
    */
   for (i = 0; i < KS_NPG; i++) {
     // Keep default prot and valid settings, but give it a new physical frame
-    add_to_list(&FrameList, (void *) NULL, PFN_TO_FNUM((*(proc->region0_pt + i)).pfn));
-    // No need to verify that we have enough frames because we just added one
-    ListNode *node = pop(&FrameList);
-    (*(proc->region0_pt + i)).pfn = FNUM_TO_PFN(node->id);
-    free(node);
+    free_frame(PFN_TO_FNUM((*(proc->region0_pt + i)).pfn));
+    // No need to verify that we have enough frames because we just freed one
+    (*(proc->region0_pt + i)).pfn = FNUM_TO_PFN(alloc_frame());
   }
   
-  // Flush the TLB with the new info
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  // Flush the old program's pages (the kernel stack frames above belong to
+  // this process' saved copy of region 0, not the live page table)
+  tlb_batch_flush(&batch);
 
 
   /*
@@ -763,6 +752,7 @@ int Yalnix_Brk(void *addr) {
   unsigned int top_pg_heap = (UP_TO_PAGE(addr) >> PAGESHIFT) - VMEM_0_PAGE_COUNT;
   unsigned int bottom_pg_stack = (DOWN_TO_PAGE(curr_proc->uc->sp) >> PAGESHIFT) - VMEM_0_PAGE_COUNT;
   unsigned int top_pg_stack = ((VMEM_1_LIMIT >> PAGESHIFT) - VMEM_1_PAGE_COUNT);
+  tlb_batch_t batch;              // Heap pages unmapped
 
   int i;
 
@@ -773,34 +763,37 @@ int Yalnix_Brk(void *addr) {
     return ERROR;
   }
 
-  /*
-  if (count_items(&FrameList) <= 0) { // if we don't have enough memory 
-  } 
-  */
-
   for (i = bottom_pg_heap; i <= top_pg_heap; i++) {
+      // Demand-paged data and bss below the heap get their frames on first touch
+      if ((*(curr_proc->region1_info + i)).flags & PG_LAZY)
+          continue;
+
       if ((*(curr_proc->region1_pt + i)).valid != 0x1) {
           
-          if (count_items(&FrameList) <= 0) {
+          if (frames_available() <= 0) {
             TracePrintf(1, "Brk Error: not enough memory available");
             return ERROR;
           }
              
           (*(curr_proc->region1_pt + i)).valid = (u_long) 0x1;
           (*(curr_proc->region1_pt + i)).prot = (u_long) (PROT_READ | PROT_WRITE);
-          ListNode *node = pop(&FrameList);
-          (*(curr_proc->region1_pt + i)).pfn = (u_long) ( (PMEM_BASE + 
-                  (node->id * PAGESIZE) ) >> PAGESHIFT);
-          free(node);
+          (*(curr_proc->region1_pt + i)).pfn = FNUM_TO_PFN(alloc_frame());
+          (*(curr_proc->region1_info + i)).flags = 0;
       }
   }
 
+  // Unmap the pages above the new break, flushing them all at the end
+  tlb_batch_init(&batch);
   for (i = top_pg_heap; i < bottom_pg_stack; i++) {
       if ((*(curr_proc->region1_pt + i)).valid == 0x1) {
-        (*(curr_proc->region1_pt + i)).valid = (u_long) 0x0;
-        add_to_list(&FrameList, (void *)NULL, ((*(curr_proc->region1_pt + i)).pfn << PAGESHIFT) / PAGESIZE);
+        free_frame(PFN_TO_FNUM((*(curr_proc->region1_pt + i)).pfn));
+        tlb_set_pte(&batch, curr_proc->region1_pt + i, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+            (u_long) 0x0, (u_long) (PROT_READ | PROT_WRITE), (u_long) 0x0);
+        (*(curr_proc->region1_info + i)).flags = 0;
+        forget_user_ranges(curr_proc);
       }
   }
+  tlb_batch_flush(&batch);
   curr_proc->brk_addr = top_pg_heap << PAGESHIFT;
   return SUCCESS;
 }
@@ -810,15 +803,11 @@ int Yalnix_Delay(UserContext *uc, int clock_ticks) {
   if (clock_ticks < 0) return ERROR;
   if (clock_ticks == 0) return SUCCESS;
 
-  // Set up the process' block to represent a delay
-  curr_proc->block->active = BLOCK_ACTIVE;
-  curr_proc->block->type = DELAY_BLOCK;
-  curr_proc->block->data.delay_count = clock_ticks;
-
-  // Add this process to the list of blocked processes
-  add_to_list(blocked_procs, curr_proc, curr_proc->proc_id);
+  // Block the process on the delay queue until its wake tick
+  if (delay_enqueue(curr_proc, clock_ticks) != SUCCESS)
+    return ERROR;
 
-  if (count_items(ready_procs) <= 0) {
+  if (sched_ready_count() <= 0) {
     TracePrintf(3, "No Items on the Ready queue to switch to!\n");
     exit(ERROR);
   } else {
@@ -829,106 +818,101 @@ int Yalnix_Delay(UserContext *uc, int clock_ticks) {
   return SUCCESS;
 } 
 
+/*
+ * Function: Yalnix_TtyWrite
+ *  @tty_id: the terminal to write to
+ *  @buf: the bytes to write
+ *  @len: number of bytes
+ *
+ * Description:
+ *    Queues the bytes on the terminal's output ring and returns; the
+ *    transmit trap sends them. Only blocks while another TtyWrite is
+ *    still queueing its bytes, or while the ring is full.
+ */
 int Yalnix_TtyWrite(int tty_id, void *buf, int len) { 
 
   TracePrintf(1, "Start: TtyWrite\n");
-  ListNode *node = find_by_id(ttys, tty_id);
-  TTY_t *tty = node->data;
-  
-  // setting up the new buffer we'll write to 
-  // needs to be on heap to survive context switch
-  if (curr_proc->write_buf->buf) 
-    free(curr_proc->write_buf->buf);
-
-  curr_proc->write_buf->buf = (char *)calloc(len, sizeof(char));
-  memcpy(((buffer*)curr_proc->write_buf)->buf, buf, len);
-  curr_proc->write_buf->len = len;
-  
-  // now we put ourselves on list of writers and start writing
-  add_to_list(tty->writers, curr_proc, curr_proc->proc_id);
-  
-  // if we're the only one, transmit
-  // otherwise we'll call transmit from trap
-  if (count_items(tty->writers) == 1) { 
-    TracePrintf(1, "PID: %d I'm the only writer - transmitting now.\n", curr_proc->proc_id);
-    if (len > TERMINAL_MAX_LINE) {
-      TtyTransmit(tty_id, buf, TERMINAL_MAX_LINE);
-    } else { 
-      TtyTransmit(tty_id, buf, len); 
-    } 
-  } else {
-    TracePrintf(1, "PID: %d Other writers exist, I'll do my writing when I'm woken up in trap transmit\n", curr_proc->proc_id);
+  TTY_t *tty = tty_lookup(tty_id);
+  int done = 0;
+
+  if (tty == NULL || len < 0) {
+    return ERROR;
   }
 
-  switch_to_next_available_proc(curr_proc->uc, 0);
+  // Wait for the writers ahead of us to finish queueing, so our bytes
+  // aren't mixed in with theirs. The one before us hands us the ring.
+  if (tty->out_writer != NULL) {
+    TracePrintf(1, "PID: %d Other writers exist, waiting my turn\n", curr_proc->proc_id);
+    enqueue(&tty->writers, curr_proc);
+    switch_to_next_available_proc(curr_proc->uc, 0);
+  }
+  tty->out_writer = curr_proc;
+
+  while (1) {
+    done += tty_put(tty, (char *) buf + done, len - done);
+    tty_start(tty);
+    if (done == len)
+      break;
+
+    // The ring is full; the transmit trap wakes us when there's room for
+    // the rest, or for half a ring if the rest won't fit anyway
+    tty->out_want = len - done;
+    if (tty->out_want > tty->out_cap / 2)
+      tty->out_want = tty->out_cap / 2;
+    tty->out_waiting = 1;
+    switch_to_next_available_proc(curr_proc->uc, 0);
+  }
 
-  TracePrintf(1, "PID: %d Finished transmitting.\n", curr_proc->proc_id);
+  // Pass the ring on to the next writer
+  tty->out_writer = dequeue(&tty->writers);
+  if (tty->out_writer != NULL)
+    make_ready(tty->out_writer, SCHED_WAKE_IO);
+
+  stats_tty(curr_proc, 0, len);
   TracePrintf(1, "End: TtyWrite\n");
   return len;
 } 
 
 
 
-/* 
-   See if we have a buffer stored (ie. somebody already wrote). 
-   If not, wait until we're woken up (should be when a buffer 
-   is waiting for us...)
-
-   Todo: handle extremely long inputs (use multiple buffers)
+/*
+ * Function: Yalnix_TtyRead
+ *  @tty_id: the terminal to read from
+ *  @buf: where to put the input
+ *  @len: most bytes to read
+ *
+ * Description:
+ *    Blocks until a line of input is waiting (and every reader that got
+ *    here first has had one), then takes up to len bytes of it. Whatever
+ *    is left of the line is what the next TtyRead gets.
+ *
+ * Returns the number of bytes read, or ERROR.
  */
 int Yalnix_TtyRead(int tty_id, void *buf, int len) { 
   
   TracePrintf(1, "Start: TtyRead\n");
-  ListNode *node = find_by_id(ttys, tty_id);
-  TTY_t *tty = node->data;
-  List *buffers = tty->buffers;
-  ListNode *buf_node = pop(buffers);
-  buffer *stored_buf;
-
-  // if there's not stored buf, switch procs, then grab 
-  // it when we're awake
-  if (!buf_node) { 
-    TracePrintf(1, "PID: %d No buffer for us. Going to wait. Should be woken up by trap tty_receive when one is available\n", curr_proc->proc_id);
-    curr_proc->read_len = len;
-    add_to_list(tty->readers, curr_proc, curr_proc->proc_id);
-    switch_to_next_available_proc(curr_proc->uc, 0);
+  TTY_t *tty = tty_lookup(tty_id);
 
-    // we just woke up, so now there should be a buff! 
-    TracePrintf(1, "PID: %d Woken up.\n", curr_proc->proc_id);
-    buf_node = pop(buffers);
-    stored_buf = buf_node->data;
-  } 
-  
-  // should be a sanity check... 
-  if (!stored_buf) { 
-    TracePrintf(3, "Something went wrong in TtyRead..\n");
-    if (buf_node)
-      free(buf_node);
+  if (tty == NULL || len < 0) {
     return ERROR;
   }
-  
-  TracePrintf(1, "PID: %d Grabbing buffer.\n", curr_proc->proc_id);
-  curr_proc->read_len = 0;
-  memcpy(buf, stored_buf->buf, len);
-  
-  int stored_buf_chars = strlen(stored_buf->buf);
-  int len_to_store = stored_buf_chars - len;
-  
-  // check if we didn't read full buffer, 
-  // put it back on list if we didn't
-  if (len_to_store > 0) {
-    TracePrintf(1, "PID: %d Didn't read entire buffer - storing the rest.\n", curr_proc->proc_id);
-    len = len - len_to_store;
-    char *buff_to_store = stored_buf->buf + len;
-    memcpy(stored_buf->buf, buff_to_store, len_to_store);
-    stored_buf->len = len_to_store;
-    add_to_list(tty->buffers, stored_buf, 0);
-  } else { 
-    TracePrintf(1, "PID: %d Read the entire buffer.\n", curr_proc->proc_id);
+
+  if (queue_count(&tty->readers) > 0 || TTY_IN_UNCLAIMED(tty) == 0) { 
+    TracePrintf(1, "PID: %d No input for us. Going to wait for tty_receive\n", curr_proc->proc_id);
+    enqueue(&tty->readers, curr_proc);
+    switch_to_next_available_proc(curr_proc->uc, 0);
+
+    // tty_wake_readers() claimed a line for us
+    tty->in_claimed--;
   } 
   
+  len = tty_get(tty, (char *) buf, len);
+
+  // A partial read leaves the line for the next reader in line
+  tty_wake_readers(tty);
+  
+  stats_tty(curr_proc, len, 0);
   TracePrintf(1, "End: TtyRead\n");
-  free(buf_node);
   return len;
 }
 
@@ -937,56 +921,52 @@ int Yalnix_CvarInit(int *cvar_idp) {
   // todo: return ERROR if 
   // validate (cvar_idp) == false
 
-  CVAR_t *cvar = (CVAR_t*)malloc(sizeof(CVAR_t));
-  cvar->id = next_resource_id;
-  next_resource_id++;
-  cvar->waiters = (List*)init_list();
+  CVAR_t *cvar = (CVAR_t *) slab_alloc(&cvar_cache);
+  if (!cvar) {
+    return ERROR;
+  }
+
+  if ((cvar->id = res_alloc(RES_CVAR, cvar)) == ERROR) {
+    slab_free(&cvar_cache, cvar);
+    return ERROR;
+  }
+  init_queue(&cvar->waiters);
   
   *cvar_idp = cvar->id;
 
-  add_to_list(cvars, cvar, cvar->id);
-
   TracePrintf(1, "Finishing: Yalnix_CvarInit\n");
   return SUCCESS;
 } 
 
 int Yalnix_CvarSignal(int cvar_id) { 
   TracePrintf(1, "Starting: Yalnix_CvarSignal\n");
-  ListNode *cvar_node = find_by_id(cvars, cvar_id);
-  if (!cvar_node) { 
+  CVAR_t *cvar = res_lookup(cvar_id, RES_CVAR);
+  if (!cvar) { 
     return ERROR;
   } 
-
-  CVAR_t *cvar = cvar_node->data;
-  ListNode *waiter_node = pop(cvar->waiters);
+  PCB_t *waiter = dequeue(&cvar->waiters);
 
   // if no waiters, do nothing.
-  if (!waiter_node) {
+  if (!waiter) {
     return SUCCESS;
   } 
 
-  PCB_t *waiter = waiter_node->data;
-  free(waiter_node);
-  add_to_list(ready_procs, waiter, waiter->proc_id);
+  make_ready(waiter, SCHED_WAKE);
    TracePrintf(1, "Finishing: Yalnix_CvarSignal\n");
   return SUCCESS;
 } 
 
 int Yalnix_CvarBroadcast(int cvar_id)  {
   TracePrintf(1, "Starting: Yalnix_CvarBroadcast\n");
-  ListNode *cvar_node = find_by_id(cvars, cvar_id);
-  if (!cvar_node) { 
+  CVAR_t *cvar = res_lookup(cvar_id, RES_CVAR);
+  if (!cvar) { 
     return ERROR;
   } 
   
-  CVAR_t *cvar = cvar_node->data;
-  
-  ListNode *waiter_node = pop(cvar->waiters);
+  PCB_t *waiter;
 
-  while(waiter_node) { 
-    PCB_t *waiter = waiter_node->data;
-    add_to_list(ready_procs, waiter, waiter->proc_id);
-    waiter_node = pop(cvar->waiters);
+  while((waiter = dequeue(&cvar->waiters)) != NULL) { 
+    make_ready(waiter, SCHED_WAKE);
   } 
   TracePrintf(1, "Finishing: Yalnix_CvarBroadcast\n"); 
   return SUCCESS;
@@ -994,30 +974,34 @@ int Yalnix_CvarBroadcast(int cvar_id)  {
 
 int Yalnix_CvarWait(int cvar_id, int lock_id) { 
   TracePrintf(1, "Starting: Yalnix_CvarWait %d\n", curr_proc->proc_id);
-  ListNode *cvar_node = find_by_id(cvars, cvar_id);
-  if (!cvar_node) { 
+  CVAR_t *cvar = res_lookup(cvar_id, RES_CVAR);
+  if (!cvar) { 
     return ERROR;
   }   
-  CVAR_t *cvar = cvar_node->data;
   
-  ListNode *lock_node = find_by_id(locks, lock_id);
-  if (!lock_node) {
+  LOCK_t *lock = res_lookup(lock_id, RES_LOCK);
+  if (!lock) {
     TracePrintf(1, "Bad luck ID given to CvarWait\n");
     return ERROR;
   } 
-  LOCK_t *lock = lock_node->data;
   
   TracePrintf(1, "%d: Releasing lock, waiting to be signaled\n", curr_proc->proc_id);
-  Yalnix_Release(lock->id);
+  // Waiting without holding the lock is an error
+  if (Yalnix_Release(lock->id) != SUCCESS) {
+    TracePrintf(1, "CvarWait: process %d doesn't hold lock %d\n", curr_proc->proc_id, lock_id);
+    return ERROR;
+  }
   
-  add_to_list(cvar->waiters, curr_proc, curr_proc->proc_id);
+  enqueue(&cvar->waiters, curr_proc);
   switch_to_next_available_proc(curr_proc->uc, 0);
   
   TracePrintf(1, "Was signaled. Acquiring lock.  %d\n", curr_proc->proc_id);
-  Yalnix_Acquire(lock->id);
+  if (Yalnix_Acquire(lock_id) != SUCCESS)
+    return ERROR;
   TracePrintf(1, "Has lock  %d\n", curr_proc->proc_id);
 
   TracePrintf(1, "Finishing: Yalnix_CvarWait\n");
+  return SUCCESS;
 }
 
 
@@ -1026,26 +1010,29 @@ int Yalnix_LockInit(int *lock_idp) {
   // todo: return ERROR if 
   // validate (lock_idp) == false
   
-  LOCK_t *lock = (LOCK_t *)malloc(sizeof(LOCK_t));
-  lock->id = next_resource_id;
-  next_resource_id++;
+  LOCK_t *lock = (LOCK_t *) slab_alloc(&lock_cache);
+  if (!lock) {
+    return ERROR;
+  }
+
+  if ((lock->id = res_alloc(RES_LOCK, lock)) == ERROR) {
+    slab_free(&lock_cache, lock);
+    return ERROR;
+  }
   lock->is_claimed = 0;
   lock->owner_id = -1;
-  lock->waiters = (List*)init_list();
+  init_queue(&lock->waiters);
 
   *lock_idp = lock->id;
 
-  add_to_list(locks, lock, lock->id);
-
   return SUCCESS;
 } 
 
 int Yalnix_Acquire(int lock_id) { 
-  ListNode *lock_node = find_by_id(locks, lock_id);
-  if (!lock_node) { 
+  LOCK_t *lock = res_lookup(lock_id, RES_LOCK);
+  if (!lock) { 
     return ERROR;
   } 
-  LOCK_t *lock = lock_node->data;
   
   if (lock->owner_id == curr_proc->proc_id) { 
     return SUCCESS;
@@ -1057,7 +1044,7 @@ int Yalnix_Acquire(int lock_id) {
     return SUCCESS;
   } 
   
-  add_to_list(lock->waiters, curr_proc, curr_proc->proc_id);
+  enqueue(&lock->waiters, curr_proc);
   switch_to_next_available_proc(curr_proc->uc, 0);
  
   // when we return from the above, we'll have the lock! 
@@ -1068,22 +1055,16 @@ int Yalnix_Acquire(int lock_id) {
 } 
 
 int Yalnix_Release(int lock_id) { 
-  ListNode *lock_node = find_by_id(locks, lock_id);
-  if (!lock_node) { 
+  LOCK_t *lock = res_lookup(lock_id, RES_LOCK);
+  if (!lock) { 
     return ERROR;
   } 
-  LOCK_t *lock = lock_node->data;
   
   if (!lock->is_claimed || lock->owner_id != curr_proc->proc_id) { 
     return ERROR;
   }
   
-  ListNode *waiter_node = pop(lock->waiters);
-  PCB_t *waiter = NULL;
-  if (waiter_node) {
-    waiter = waiter_node->data;
-    free(waiter_node);
-  }
+  PCB_t *waiter = dequeue(&lock->waiters);
   
   if (!waiter) { 
     lock->is_claimed = 0;
@@ -1092,52 +1073,233 @@ int Yalnix_Release(int lock_id) {
   } 
 
   // else, there's a waiter, so let's give them the lock 
-  // and let them wake up (add to ready_procs)
+  // and let them wake up (make them ready)
   lock->owner_id = waiter->proc_id;
-  add_to_list(ready_procs, waiter, waiter->proc_id);
+  make_ready(waiter, SCHED_WAKE);
   
   return SUCCESS;
 } 
 
+/*
+ * Function: Yalnix_SemInit
+ *  @sem_idp: pointer to the int that will hold the semaphore's id
+ *  @value: the semaphore's initial value
+ *
+ * Returns SUCCESS, or ERROR if value is negative or no id could be made.
+ */
+int Yalnix_SemInit(int *sem_idp, int value) {
+  SEM_t *sem;
+
+  if (value < 0) {
+    TracePrintf(1, "SemInit: negative initial value %d\n", value);
+    return ERROR;
+  }
+
+  sem = (SEM_t *) slab_alloc(&sem_cache);
+  if (!sem) {
+    return ERROR;
+  }
+
+  if ((sem->id = res_alloc(RES_SEM, sem)) == ERROR) {
+    slab_free(&sem_cache, sem);
+    return ERROR;
+  }
+  sem->value = value;
+  init_queue(&sem->waiters);
+
+  *sem_idp = sem->id;
+
+  return SUCCESS;
+}
+
+/*
+ * Function: Yalnix_SemUp
+ *  @sem_id: the semaphore to increment
+ *
+ * Wakes the oldest waiter with the unit if anyone is waiting, and
+ * otherwise adds it to the value.
+ */
+int Yalnix_SemUp(int sem_id) {
+  SEM_t *sem = res_lookup(sem_id, RES_SEM);
+  PCB_t *waiter;
+
+  if (!sem) {
+    return ERROR;
+  }
+
+  waiter = dequeue(&sem->waiters);
+  if (!waiter) {
+    sem->value++;
+    return SUCCESS;
+  }
+
+  make_ready(waiter, SCHED_WAKE);
+  return SUCCESS;
+}
+
+/*
+ * Function: Yalnix_SemDown
+ *  @sem_id: the semaphore to decrement
+ *
+ * Takes a unit if one is available, and otherwise blocks until a SemUp
+ * hands this process one.
+ */
+int Yalnix_SemDown(int sem_id) {
+  SEM_t *sem = res_lookup(sem_id, RES_SEM);
+
+  if (!sem) {
+    return ERROR;
+  }
+
+  if (sem->value > 0) {
+    sem->value--;
+    return SUCCESS;
+  }
+
+  enqueue(&sem->waiters, curr_proc);
+  switch_to_next_available_proc(curr_proc->uc, 0);
+
+  // The unit was handed to us in SemUp
+  return SUCCESS;
+}
+
+/*
+ * Function: pipe_put
+ *  @pipe: the pipe to write into
+ *  @src: bytes to write
+ *  @len: number of bytes, no more than PIPE_ROOM(pipe)
+ *
+ * Copies into the ring in at most two pieces (when it wraps).
+ */
+static void pipe_put(pipe_t *pipe, char *src, unsigned int len) {
+  unsigned int off = pipe->tail & (pipe->cap - 1);
+  unsigned int first = pipe->cap - off;
+
+  if (first > len)
+    first = len;
+
+  memcpy(pipe->buf + off, src, first);
+  memcpy(pipe->buf, src + first, len - first);
+  pipe->tail += len;
+}
+
+/*
+ * Function: pipe_get
+ *  @pipe: the pipe to read from
+ *  @dest: where to put the bytes
+ *  @len: number of bytes, no more than PIPE_LEN(pipe)
+ */
+static void pipe_get(pipe_t *pipe, char *dest, unsigned int len) {
+  unsigned int off = pipe->head & (pipe->cap - 1);
+  unsigned int first = pipe->cap - off;
+
+  if (first > len)
+    first = len;
+
+  memcpy(dest, pipe->buf + off, first);
+  memcpy(dest + first, pipe->buf, len - first);
+  pipe->head += len;
+}
+
+/*
+ * Function: pipe_handoff
+ *  @reader: the reader at the head of the pipe's wait queue
+ *  @src: the current process' data
+ *  @len: bytes available at src
+ *
+ * Copies as much of @src as @reader still wants straight into its buffer,
+ * and wakes it once it has all of it (or if the copy failed).
+ *
+ * Returns the number of bytes of @src used up.
+ */
+static unsigned int pipe_handoff(PCB_t *reader, char *src, unsigned int len) {
+  unsigned int n = reader->read_len - reader->read_got;
+
+  if (n > len)
+    n = len;
+
+  if (copy_to_proc(reader, (char *) reader->read_buf + reader->read_got, src, n) != SUCCESS) {
+    TracePrintf(3, "pipe_handoff: can't copy into process %d's buffer\n", reader->proc_id);
+    reader->read_got = ERROR;
+    dequeue_proc(reader);
+    make_ready(reader, SCHED_WAKE_IO);
+    return 0;
+  }
+
+  reader->read_got += n;
+  stats_pipe(reader, n, 0);
+
+  if (reader->read_got == reader->read_len) {
+    dequeue_proc(reader);
+    make_ready(reader, SCHED_WAKE_IO);
+  }
+
+  return n;
+}
+
+/*
+ * Function: pipe_wake_writers
+ *  @pipe: a pipe that may have room nobody has claimed
+ *
+ * Wakes blocked writers, oldest first, while there's unclaimed room,
+ * granting each as much as it needs or as much as is left. The grant
+ * replaces the writer's write_len. Called whenever room may have been
+ * left unclaimed: after a read, and by a writer on its way out.
+ */
+static void pipe_wake_writers(pipe_t *pipe) {
+  PCB_t *writer;
+  unsigned int room;
+
+  while ((writer = queue_head(&pipe->writers)) != NULL &&
+      (room = PIPE_FREE_ROOM(pipe)) > 0) {
+    dequeue_proc(writer);
+    if (writer->write_len > room)
+      writer->write_len = room;
+    pipe->room_owed += writer->write_len;
+    make_ready(writer, SCHED_WAKE_IO);
+  }
+}
+
 /*
  * Yalnix_PipeInit
  *  @pip_idp Pointer to the int that will hold the pipe's identifier
  *
- * TO DO:
- *  - Check that we haven't exhausted all of the resource identifiers
+ * The pipe's capacity is pipe_capacity rounded up to a power of two.
  */
 int Yalnix_PipeInit(int *pip_idp) {
   TracePrintf(1, "Starting: Yalnix_PipeInit\n");
   // Local Variables
   pipe_t *pipe;
+  unsigned int cap;
+
+  // Round the capacity up to a power of two so indices can be masked
+  for (cap = MIN_PIPE_LEN; cap < pipe_capacity && cap < PIPE_LEN_LIMIT; cap <<= 1)
+    ;
 
   // Allocate space for a new Pipe
-  pipe = (pipe_t *) malloc( sizeof(pipe_t) );
+  pipe = (pipe_t *) slab_alloc(&pipe_cache);
   if (pipe == NULL)
     return ERROR;
   
-  pipe->buf = (char *) malloc( sizeof(char) * MAX_PIPE_LEN );
+  pipe->buf = (char *) malloc( sizeof(char) * cap );
   if (pipe->buf == NULL) {
-    free(pipe);
+    slab_free(&pipe_cache, pipe);
     return ERROR;
   }
 
-  pipe->waiters = (List *) init_list();
-  if (pipe->waiters == NULL) {
+  init_queue(&pipe->waiters);
+  init_queue(&pipe->writers);
+
+  // Initialize the new pipe to be empty
+  if ((pipe->id = res_alloc(RES_PIPE, (void *)pipe)) == ERROR) {
     free(pipe->buf);
-    free(pipe);
+    slab_free(&pipe_cache, pipe);
     return ERROR;
   }
-
-  // Initialize the new pipe to be empty
-  // TO DO: Check if we've reached the max resource count
-  pipe->id = next_resource_id++;
-  pipe->len = 0;
-  pipe->waiters->first = NULL;
-  bzero(pipe->buf, sizeof(char) * MAX_PIPE_LEN);
-
-  // Add the new pipe to the list of pipes
-  add_to_list(pipes, (void *)pipe, pipe->id);
+  pipe->cap = cap;
+  pipe->head = 0;
+  pipe->tail = 0;
+  pipe->room_owed = 0;
 
   // Copy the pipe identifier into the userland variable
   *pip_idp = pipe->id;
@@ -1153,6 +1315,10 @@ int Yalnix_PipeInit(int *pip_idp) {
  *  @len
  *
  * Description:
+ *    Blocks until len bytes have been read. Whatever is in the pipe is
+ *    taken right away; the rest is copied into buf by writers while we're
+ *    blocked. Readers are served in the order they arrive. Reads more than
+ *    the pipe can ever hold fail.
  *
  * To Do:
  *
@@ -1160,102 +1326,130 @@ int Yalnix_PipeInit(int *pip_idp) {
 int Yalnix_PipeRead(int pipe_id, void *buf, int len) {
   TracePrintf(1, "Starting: Yalnix_PipeRead\n");
   // Local variables
-  ListNode *pipe_node;
-  pipe_t *pipe = NULL;
+  pipe_t *pipe;
+  unsigned int got;
 
   // Check that the pipe exists
-  pipe_node = find_by_id(pipes, pipe_id);
-
-  if (pipe_node)
-    pipe = pipe_node->data;
+  pipe = res_lookup(pipe_id, RES_PIPE);
 
   if (!pipe)
     return(ERROR);
 
   // Check the validity of the number of characters to read from the pipe
-  if (len > MAX_PIPE_LEN)
+  if (len < 0 || (unsigned int) len > pipe->cap)
     return(ERROR);
 
-  // If there are not len characters to read, block until there is
-  if (len > pipe->len) {
-    // Note that it's id in the list is the number of characters it needs
-    add_to_list(pipe->waiters, (void *) curr_proc, len);
-    switch_to_next_available_proc(curr_proc->uc, 0);
+  // Take what's in the pipe, unless earlier readers are waiting for it
+  got = 0;
+  if (queue_count(&pipe->waiters) == 0) {
+    got = PIPE_LEN(pipe);
+    if (got > len)
+      got = len;
+    pipe_get(pipe, (char *) buf, got);
+    stats_pipe(curr_proc, got, 0);
   }
 
-  // When we get back here, we'll be able to do the read
-  memmove((void *)buf, (void *)pipe->buf, len);
+  // Now there may be room for blocked writers to make progress
+  pipe_wake_writers(pipe);
 
-  // Shift the contents of the pipe's buffer down to the beginning
-  memmove((void *)pipe->buf, (void *)(pipe->buf + len), MAX_PIPE_LEN - len);
-  bzero(pipe->buf + (MAX_PIPE_LEN - len), len);
+  // Writers hand us the rest directly
+  if (got < len) {
+    curr_proc->read_buf = buf;
+    curr_proc->read_len = len;
+    curr_proc->read_got = got;
+    enqueue(&pipe->waiters, curr_proc);
+    switch_to_next_available_proc(curr_proc->uc, 0);
 
-  // Reset the index for the pipe
-  pipe->len -= len;
+    if (curr_proc->read_got == ERROR)
+      return(ERROR);
+  }
 
   TracePrintf(1, "Finishing: Yalnix_PipeRead\n");
   return(len);
 } 
 
 
-// BUGS: only works with one waiter at a time!
+/*
+ * Function: Yalnix_PipeWrite
+ *  @pipe_id
+ *  @buf
+ *  @len
+ *
+ * Description:
+ *    Blocked readers are given their data straight from buf. Anything
+ *    left over goes into the pipe, blocking for room if it's full, so a
+ *    write larger than the pipe completes in pieces as readers drain it.
+ *    Blocked writers take turns in the order they blocked, one piece at a
+ *    time.
+ *
+ * To Do:
+ *
+ */
 int Yalnix_PipeWrite(int pipe_id, void *buf, int len) { 
   TracePrintf(1, "Starting: Yalnix_PipeWrite\n");
   // Local varialbes
-  ListNode *pipe_node;
-  pipe_t *pipe = NULL;
-  ListNode *waiter_node;
-  PCB_t *waiter_proc;
-  int required_len;
+  pipe_t *pipe;
+  PCB_t *reader;
+  unsigned int written;
+  unsigned int n;
+  int granted;
   
 
   // Check that the pipe exists
-  pipe_node = find_by_id(pipes, pipe_id);
-
-  if (pipe_node)
-    pipe = pipe_node->data;
+  pipe = res_lookup(pipe_id, RES_PIPE);
 
   if (!pipe)
     return(ERROR);
 
-  // Check the validity of len parameter
-  //   Can't write more to the pipe than the space we have left
-  if (len > (MAX_PIPE_LEN - pipe->len))
+  if (len < 0)
     return(ERROR);
 
-  // Copy the characters in and update the pipe's index
-  memmove((void *)(pipe->buf + pipe->len), (void *)buf, len);
-  pipe->len += len;
-  
-  // Take the next waiter off of the list of waiters if possible
-  waiter_proc = NULL;
-  // TO DO: Change this to be a non-removing version of pop!
-  waiter_node = pop(pipe->waiters);
-  int waiter_id;
-  if (waiter_node) { 
-    waiter_proc = (PCB_t *) waiter_node->data;
-    waiter_id = waiter_node->id;
-  }
-  // Check to see if this waiter should be kept on the list or put back on to
-  // waiters
-  if (waiter_proc) {
-    required_len = waiter_node->id;
-
-    if (required_len > pipe->len) {
-      // Put it back on the wait list
-      add_to_list(pipe->waiters, (void *)waiter_proc, required_len);
-    } else { // Put it on the ready queue
-      add_to_list(ready_procs, (void *)waiter_proc, waiter_proc->proc_id);
+  granted = 0;
+  written = 0;
+  while (written < (unsigned int) len) {
+    // Readers only wait on an empty pipe, so they get the next bytes
+    if ((reader = queue_head(&pipe->waiters)) != NULL) {
+      n = pipe_handoff(reader, (char *) buf + written, len - written);
+      stats_pipe(curr_proc, 0, n);
+      written += n;
+      continue;
+    }
+
+    // Wait for a reader to make room (and for earlier writers to go)
+    if ((!granted && queue_count(&pipe->writers) > 0) || PIPE_FREE_ROOM(pipe) == 0) {
+      // Room nobody has claimed goes to the writers ahead of us first
+      if (queue_count(&pipe->writers) > 0 && PIPE_FREE_ROOM(pipe) > 0) {
+        pipe_wake_writers(pipe);
+        continue;
+      }
+
+      curr_proc->write_len = len - written;
+      enqueue(&pipe->writers, curr_proc);
+      switch_to_next_available_proc(curr_proc->uc, 0);
+
+      // pipe_wake_writers set write_len bytes of room aside for us; give
+      // it back to the pipe, and take it below unless a reader gets the
+      // bytes first
+      pipe->room_owed -= curr_proc->write_len;
+      granted = 1;
+      continue;
     }
 
-    // Free the waiter_node returned from pop
-    free(waiter_node);
+    // Copy in as much as fits
+    n = PIPE_FREE_ROOM(pipe);
+    if (n > len - written)
+      n = len - written;
+    pipe_put(pipe, (char *) buf + written, n);
+    stats_pipe(curr_proc, 0, n);
+    written += n;
+    granted = 0;
   }
 
-  TracePrintf(1, "Finishing: Yalnix_PipeWrite\n");
-  if (waiter_node)
-    free(waiter_node);
+  // If readers took our bytes directly, the room we were granted is still
+  // free; pass it on to the writers behind us
+  pipe_wake_writers(pipe);
 
+  TracePrintf(1, "Finishing: Yalnix_PipeWrite\n");
   return len;
 } 
 
@@ -1263,55 +1457,78 @@ int Yalnix_PipeWrite(int pipe_id, void *buf, int len) {
    Destory lock, condition variable, or piped identified by id
    and release resources. 
    If this function is called and processes
-   are waiting on the resource, or have it locked, this returns ERROR
+   are waiting on the resource, or have it locked, or the id isn't a
+   live resource, this returns ERROR
    Otherwise returns SUCCESS
 */
 int Yalnix_Reclaim(int id) { 
 
-  ListNode *node; 
-  
-  if (node = find_by_id(locks, id)) { 
-    
-    LOCK_t *lock = node->data;
+  LOCK_t *lock;
+  CVAR_t *cvar;
+  SEM_t *sem;
+  pipe_t *pipe;
 
-    if (count_items(lock->waiters) > 0) { 
-      TracePrintf(1, "Can't reclaim lock: people are waiting on it.");
-      return ERROR;
-    } 
-    
-    if (lock->is_claimed) {
-      TracePrintf(1, "Can't reclaim lock: someone has it");
-      return ERROR;
-    }
-    
-    remove_from_list(locks, node->data);
-    free(lock);
-    
-  } else if (node = find_by_id(cvars, id)) { 
-    
-    CVAR_t *cvar = node->data;
-    
-    if (count_items(cvar->waiters) > 0) { 
-      TracePrintf(1, "Can't reclaim cvar: people are waiting on it.");
-      return ERROR;
-    } 
-    
-    remove_from_list(cvars, node->data);
-    free(cvar);
-    
-  } else if (node = find_by_id(pipes, id)) { 
+  switch (res_type(id)) {
+    case RES_LOCK:
+      lock = res_lookup(id, RES_LOCK);
+
+      if (queue_count(&lock->waiters) > 0) { 
+        TracePrintf(1, "Can't reclaim lock: people are waiting on it.");
+        return ERROR;
+      } 
+      
+      if (lock->is_claimed) {
+        TracePrintf(1, "Can't reclaim lock: someone has it");
+        return ERROR;
+      }
+      
+      res_free(id);
+      slab_free(&lock_cache, lock);
+      break;
+
+    case RES_CVAR:
+      cvar = res_lookup(id, RES_CVAR);
+      
+      if (queue_count(&cvar->waiters) > 0) { 
+        TracePrintf(1, "Can't reclaim cvar: people are waiting on it.");
+        return ERROR;
+      } 
+      
+      res_free(id);
+      slab_free(&cvar_cache, cvar);
+      break;
+
+    case RES_SEM:
+      sem = res_lookup(id, RES_SEM);
+
+      if (queue_count(&sem->waiters) > 0) {
+        TracePrintf(1, "Can't reclaim semaphore: people are waiting on it.");
+        return ERROR;
+      }
 
-    pipe_t *pipe = node->data;
-    
-    if (count_items(pipe->waiters) > 0) { 
-      TracePrintf(1, "Can't reclaim pipe: people are waiting on it.");
+      res_free(id);
+      slab_free(&sem_cache, sem);
+      break;
+
+    case RES_PIPE:
+      pipe = res_lookup(id, RES_PIPE);
+      
+      // Processes that were woken but haven't run yet count as waiting
+      if (queue_count(&pipe->waiters) > 0 || queue_count(&pipe->writers) > 0 ||
+          pipe->room_owed > 0) { 
+        TracePrintf(1, "Can't reclaim pipe: people are waiting on it.");
+        return ERROR;
+      } 
+      
+      res_free(id);
+      free(pipe->buf);
+      slab_free(&pipe_cache, pipe);
+      break;
+
+    default:
+      TracePrintf(1, "Can't reclaim %d: no such resource", id);
       return ERROR;
-    } 
-    
-    remove_from_list(pipes, node->data);
-    free(pipe->buf);
-    free(pipe);
-  } 
+  }
   
   return SUCCESS;
   
@@ -43,6 +43,16 @@ int Yalnix_CvarBroadcast(int cvar_id);
 int Yalnix_CvarWait(int cvar_id, int lock_id);
 
 
+/*
+ * Semaphore syscalls
+ */
+int Yalnix_SemInit(int *sem_idp, int value);
+
+int Yalnix_SemUp(int sem_id);
+
+int Yalnix_SemDown(int sem_id);
+
+
 /*
  * Syscalls implemented in tty.c (moved to gen_syscalls.c) 
  */
@@ -59,5 +69,45 @@ int Yalnix_PipeRead(int pipe_id, void *buf, int len);
 
 int Yalnix_PipeWrite(int pipe_id, void *buf, int len);
 
+/*
+ * Syscalls implemented in ipc.c
+ */
+int Yalnix_Register(unsigned int index);
+
+int Yalnix_Send(void *msg, int pid);
+
+int Yalnix_Receive(void *msg);
+
+int Yalnix_ReceiveSpecific(void *msg, int pid);
+
+int Yalnix_Reply(void *msg, int pid);
+
+int Yalnix_Forward(void *msg, int pid, int src_pid);
+
+int Yalnix_CopyFrom(int src_pid, void *dest, void *src, int len);
+
+int Yalnix_CopyTo(int dest_pid, void *dest, void *src, int len);
+
+/*
+ * Syscalls implemented in bcache.c
+ */
+int Yalnix_ReadSector(int sector, void *buf);
+
+int Yalnix_WriteSector(int sector, void *buf);
+
+int Yalnix_Sync();
+
+/*
+ * Syscalls implemented in stats.c
+ */
+int Yalnix_Stats(int which, void *buf, int pid);
+
+/*
+ * Syscalls implemented in batch.c
+ */
+struct batch_op_t;
+
+int Yalnix_Batch(UserContext *uc, struct batch_op_t *ops, int count, int flags);
+
 
 #endif // end _SYSCALL_H_
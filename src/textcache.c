@@ -0,0 +1,183 @@
+/*
+ * File: textcache.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the shared text cache declared in textcache.h.
+ *    The cache is a singly linked list of entries; there are only ever as
+ *    many entries as there are distinct programs running, so lookups just
+ *    walk it. Text pages are read into their frames through the scratch
+ *    page (see map_scratch_frame()), so a page can be loaded on behalf of
+ *    any process, with any page table installed.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *    An executable that is rewritten in place gets a new entry the next
+ *    time it's loaded, but processes already running the old entry may
+ *    still page in text from the new file.
+ */
+
+/* System Includes */
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hardware.h>
+#include <yalnix.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "frames.h"
+#include "textcache.h"
+
+/*
+ * Private Variables
+ */
+static text_t *text_cache = NULL;  // All text segments in use
+
+/*
+ * Function: text_acquire
+ *  @path: the executable being loaded
+ *  @faddr: file offset of the executable's text
+ *  @npg: number of pages of text
+ *
+ * Finds the cache entry for the current version of the executable, or
+ * creates an empty one, and counts the caller as one of its users.
+ *
+ * Returns the entry, or NULL if the file can't be stat'd or the kernel
+ * heap is out of space (the caller should load a private copy instead).
+ */
+text_t *text_acquire(char *path, long faddr, int npg) {
+  struct stat st;
+  text_t *text;
+  int i;
+
+  if (stat(path, &st) < 0) {
+    TracePrintf(3, "text_acquire: can't stat '%s'\n", path);
+    return NULL;
+  }
+
+  for (text = text_cache; text != NULL; text = text->next) {
+    if (text->mtime == st.st_mtime && text->faddr == faddr &&
+        text->npg == npg && strcmp(text->path, path) == 0) {
+      text->users++;
+      return text;
+    }
+  }
+
+  text = (text_t *) malloc(sizeof(text_t));
+  if (text == NULL)
+    return NULL;
+
+  text->path = (char *) malloc(strlen(path) + 1);
+  text->fnums = (int *) malloc(npg * sizeof(int));
+  if (text->path == NULL || text->fnums == NULL) {
+    free(text->path);
+    free(text->fnums);
+    free(text);
+    return NULL;
+  }
+
+  strcpy(text->path, path);
+  text->mtime = st.st_mtime;
+  text->faddr = faddr;
+  text->npg = npg;
+  for (i = 0; i < npg; i++)
+    text->fnums[i] = ERROR;
+  text->users = 1;
+
+  text->next = text_cache;
+  text_cache = text;
+
+  return text;
+}
+
+/*
+ * Function: text_dup
+ *  @text: an entry in use by a process that's forking
+ */
+void text_dup(text_t *text) {
+  if (text != NULL)
+    text->users++;
+}
+
+/*
+ * Function: text_release
+ *  @text: an entry the calling process no longer runs
+ *
+ * When the last user goes, the cache's references to the text frames are
+ * dropped and the entry is freed.
+ */
+void text_release(text_t *text) {
+  text_t **link;
+  int i;
+
+  if (text == NULL || --text->users > 0)
+    return;
+
+  for (link = &text_cache; *link != NULL; link = &(*link)->next) {
+    if (*link == text) {
+      *link = text->next;
+      break;
+    }
+  }
+
+  for (i = 0; i < text->npg; i++) {
+    if (text->fnums[i] != ERROR)
+      free_frame(text->fnums[i]);
+  }
+
+  free(text->fnums);
+  free(text->path);
+  free(text);
+}
+
+/*
+ * Function: text_frame
+ *  @text: a cache entry
+ *  @idx: index of the page within the text
+ *  @fd: an open descriptor for the executable, in case the page isn't read
+ *
+ * The frame returned is still owned by the cache; a process that maps it
+ * must take its own reference with ref_frame().
+ *
+ * Returns the frame number, or ERROR if no frame is free or the read failed.
+ */
+int text_frame(text_t *text, int idx, int fd) {
+  void *page;
+  int fnum;
+  int nread;
+
+  if (idx < 0 || idx >= text->npg)
+    return ERROR;
+
+  if (text->fnums[idx] != ERROR)
+    return text->fnums[idx];
+
+  if ((fnum = alloc_frame()) == ERROR) {
+    TracePrintf(3, "text_frame: no frames left for page %d of '%s'\n", idx, text->path);
+    return ERROR;
+  }
+
+  page = map_scratch_frame(fnum);
+
+  nread = -1;
+  if (lseek(fd, text->faddr + (idx << PAGESHIFT), SEEK_SET) >= 0)
+    nread = read(fd, page, PAGESIZE);
+
+  if (nread >= 0 && nread < PAGESIZE)
+    bzero((char *) page + nread, PAGESIZE - nread);
+
+  unmap_scratch_frame();
+
+  if (nread < 0) {
+    TracePrintf(3, "text_frame: failed to read page %d of '%s'\n", idx, text->path);
+    free_frame(fnum);
+    return ERROR;
+  }
+
+  text->fnums[idx] = fnum;
+  return fnum;
+}
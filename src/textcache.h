@@ -0,0 +1,58 @@
+/*
+ * File:  textcache.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    A cache of program text shared between processes running the same
+ *    executable. Entries are keyed by the executable's path and mtime, and
+ *    hold one physical frame per text page once that page has been read.
+ *    Every process running the program maps the same frames read-only and
+ *    executable, so the text is read from disk and kept in memory once no
+ *    matter how many copies of the program are running.
+ *
+ * Contents:
+ *    text_t              - A cached text segment
+ *    text_acquire()      - Find (or create) the entry for an executable
+ *    text_dup()          - Add a user to an entry (for Fork)
+ *    text_release()      - Drop a user; the entry is freed with its last user
+ *    text_frame()        - Frame holding a text page, reading it if needed
+ *
+ * Warnings:
+ *    The cache holds its own reference on each frame it loads, and every
+ *    process mapping the frame holds another (see ref_frame()). A process
+ *    must free its mappings before calling text_release().
+ */
+
+#ifndef _TEXTCACHE_H_
+#define _TEXTCACHE_H_
+
+/*
+ * System includes
+ */
+#include <time.h>
+
+/*
+ * text_t datatype
+ *
+ * The text segment of one version of one executable.
+ */
+typedef struct text_t {
+  char *path;               // Path the executable was loaded from
+  time_t mtime;             // Modification time of the executable when loaded
+  long faddr;               // File offset of the start of the text
+  int npg;                  // Number of pages of text
+  int *fnums;               // Frame of each text page, or ERROR if not read yet
+  int users;                // Number of processes running this text
+  struct text_t *next;      // Next entry in the cache
+} text_t;
+
+/*
+ * Public Prototypes
+ */
+text_t *text_acquire(char *path, long faddr, int npg);
+void text_dup(text_t *text);
+void text_release(text_t *text);
+int text_frame(text_t *text, int idx, int fd);
+
+#endif // _TEXTCACHE_H_
@@ -0,0 +1,136 @@
+/*
+ * File: tlb.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the TLB maintenance routines declared in tlb.h.
+ *
+ *    Every region flush a batch or tlb_flush_page() avoids by flushing
+ *    single pages instead is counted in kstats.tlb_flushes_saved.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "stats.h"
+#include "tlb.h"
+
+/*
+ * Function: tlb_flush
+ *  @what: TLB_FLUSH_ALL, TLB_FLUSH_0, TLB_FLUSH_1, or a virtual address
+ *         whose page should be flushed
+ */
+void tlb_flush(unsigned int what) {
+  switch ((int) what) {
+    case TLB_FLUSH_ALL:
+      kstats.tlb_flushes[FLUSH_ALL]++;
+      break;
+    case TLB_FLUSH_0:
+      kstats.tlb_flushes[FLUSH_REGION_0]++;
+      break;
+    case TLB_FLUSH_1:
+      kstats.tlb_flushes[FLUSH_REGION_1]++;
+      break;
+    default:
+      kstats.tlb_flushes[FLUSH_PAGE]++;
+      break;
+  }
+
+  WriteRegister(REG_TLB_FLUSH, what);
+}
+
+/*
+ * Function: tlb_flush_page
+ *  @addr: any address in the page whose mapping changed
+ *
+ * For a single PTE change, in place of flushing the page's whole region.
+ */
+void tlb_flush_page(void *addr) {
+  tlb_flush(DOWN_TO_PAGE(addr));
+  kstats.tlb_flushes_saved++;
+}
+
+/*
+ * Function: tlb_batch_init
+ *  @batch: the batch to empty
+ */
+void tlb_batch_init(tlb_batch_t *batch) {
+  batch->count[0] = 0;
+  batch->count[1] = 0;
+}
+
+/*
+ * Function: tlb_batch_add
+ *  @batch: the batch to record the change in
+ *  @addr: any address in the page whose mapping changed
+ */
+void tlb_batch_add(tlb_batch_t *batch, void *addr) {
+  int region = ((unsigned int) addr >= VMEM_1_BASE);
+  unsigned int page = DOWN_TO_PAGE(addr);
+  int i;
+
+  // Already overflowed: the whole region gets flushed anyway
+  if (batch->count[region] > TLB_BATCH_PAGES)
+    return;
+
+  for (i = 0; i < batch->count[region]; i++) {
+    if (batch->addrs[region][i] == page)
+      return;
+  }
+
+  if (batch->count[region] < TLB_BATCH_PAGES)
+    batch->addrs[region][batch->count[region]] = page;
+  batch->count[region]++;
+}
+
+/*
+ * Function: tlb_batch_flush
+ *  @batch: the batch to flush
+ *
+ * Flushes each page recorded in the batch, or the whole region for a
+ * region that overflowed, and empties the batch.
+ */
+void tlb_batch_flush(tlb_batch_t *batch) {
+  int region;
+  int i;
+
+  for (region = 0; region < 2; region++) {
+    if (batch->count[region] > TLB_BATCH_PAGES) {
+      tlb_flush(region ? TLB_FLUSH_1 : TLB_FLUSH_0);
+    } else if (batch->count[region] > 0) {
+      for (i = 0; i < batch->count[region]; i++)
+        tlb_flush(batch->addrs[region][i]);
+      kstats.tlb_flushes_saved++;
+    }
+  }
+
+  tlb_batch_init(batch);
+}
+
+/*
+ * Function: tlb_set_pte
+ *  @batch: the batch to record the change in
+ *  @pte: a PTE in the page tables the hardware is using
+ *  @addr: the virtual address @pte maps
+ *  @valid, @prot, @pfn: the new contents of the PTE
+ *
+ * Only records the page if the PTE actually changes.
+ */
+void tlb_set_pte(tlb_batch_t *batch, struct pte *pte, void *addr,
+    u_long valid, u_long prot, u_long pfn) {
+  if (pte->valid == valid && pte->prot == prot && pte->pfn == pfn)
+    return;
+
+  pte->valid = valid;
+  pte->prot = prot;
+  pte->pfn = pfn;
+  tlb_batch_add(batch, addr);
+}
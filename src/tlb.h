@@ -0,0 +1,68 @@
+/*
+ * File:  tlb.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    TLB maintenance. Every TLB flush in the kernel goes through here so
+ *    that flushes can be counted by kind (see kstats_t).
+ *
+ *    Code that changes a handful of PTEs should change them through
+ *    tlb_set_pte() with a tlb_batch_t, and call tlb_batch_flush() once it's
+ *    done. The batch remembers which pages changed and flushes just those,
+ *    unless more than TLB_BATCH_PAGES changed in a region, in which case
+ *    flushing the whole region is cheaper:
+ *
+ *        tlb_batch_t batch;
+ *        tlb_batch_init(&batch);
+ *        for (...)
+ *          tlb_set_pte(&batch, pte, addr, valid, prot, pfn);
+ *        tlb_batch_flush(&batch);
+ *
+ * Contents:
+ *    TLB_BATCH_PAGES     - Most pages per region flushed one at a time
+ *    tlb_batch_t         - The pages changed since the last flush
+ *    tlb_flush()         - Flush one page, one region, or the whole TLB
+ *    tlb_flush_page()    - Flush the page holding an address
+ *    tlb_batch_*()       - Batch up PTE changes and flush them together
+ *    tlb_set_pte()       - Change a live PTE, recording it in a batch
+ *
+ * Warnings:
+ *    A batch only knows about addresses, so the PTEs it's given must be in
+ *    the page tables the hardware is using right now.
+ */
+
+#ifndef _TLB_H_
+#define _TLB_H_
+
+#include <hardware.h>
+
+/*
+ * Public Constant Definitions
+ */
+#define TLB_BATCH_PAGES   8     // Past this, a region flush is cheaper
+
+/*
+ * tlb_batch_t datatype
+ *
+ * Pages changed in each region since the batch was last flushed. A count
+ * past TLB_BATCH_PAGES means the region has overflowed and will be flushed
+ * whole.
+ */
+typedef struct tlb_batch_t {
+  int count[2];                               // Pages changed in region 0/1
+  unsigned int addrs[2][TLB_BATCH_PAGES];     // Their page-aligned addresses
+} tlb_batch_t;
+
+/*
+ * Public Prototypes
+ */
+void tlb_flush(unsigned int what);
+void tlb_flush_page(void *addr);
+void tlb_batch_init(tlb_batch_t *batch);
+void tlb_batch_add(tlb_batch_t *batch, void *addr);
+void tlb_batch_flush(tlb_batch_t *batch);
+void tlb_set_pte(tlb_batch_t *batch, struct pte *pte, void *addr,
+    u_long valid, u_long prot, u_long pfn);
+
+#endif // _TLB_H_
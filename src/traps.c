@@ -14,11 +14,8 @@
  * Private Helper Functions
  */ 
 int chk_range(u_long ptr);                                                      
-int chk_valid(u_long ptr);                                                      
-int chk_read(u_long ptr);                                                       
-int chk_write(u_long ptr);                                                      
-int chk_rw(u_long ptr); 
-int chk_str(u_long ptr, int len);
+int chk_buf(u_long ptr, int len, int prot);
+int chk_exec_args(u_long fname, u_long argv);
 
 // used by a couple different traps
 void abort_current_process(int exit_code, UserContext *uc) {
@@ -37,6 +34,17 @@ like creating new process, mem allocation or I/O.
 
 */
 void HANDLE_TRAP_KERNEL(UserContext *uc) { 
+  stats_syscall(curr_proc, uc->code);
+  uc->regs[0] = do_syscall(uc);
+}
+
+/*
+ * Checks the arguments of the syscall uc->code and runs it. Batched
+ * syscalls come through here too, each with its own UserContext.
+ *
+ * Returns the syscall's return value.
+ */
+int do_syscall(UserContext *uc) {
   // arguments to kernel call are in uc->regs
   // execute requested kernal call (uc->code)
 
@@ -65,13 +73,13 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
           retval = ERROR;
           break;
         }
-        if (chk_valid(uc->regs[0]) || chk_valid(uc->regs[1])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer to invalid page\n");
+        if (chk_exec_args(uc->regs[0], uc->regs[1])) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: could not page in exec arguments\n");
           retval = ERROR;
           break;
         }
-        if (chk_rw(uc->regs[0]) || chk_rw(uc->regs[1])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: no read or write permissions for pointer argument\n");
+        if (chk_buf(uc->regs[0], 1, PROT_READ)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
           retval = ERROR;
           break;
         }
@@ -85,18 +93,8 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         break;
 
       case YALNIX_WAIT:
-        if (chk_range(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer out of range\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_valid(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer to invalid page\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_rw(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: no read or write permissions for pointer argument\n");
+        if (chk_buf(uc->regs[0], sizeof(int), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
           retval = ERROR;
           break;
         }
@@ -114,16 +112,6 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
           retval = ERROR;
           break;
         }
-        if (chk_valid(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer to invalid page\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_rw(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: no read or write permissions for pointer argument\n");
-          retval = ERROR;
-          break;
-        }
         addr = (void *) uc->regs[0];
         retval = Yalnix_Brk(addr);
         break;
@@ -134,7 +122,7 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         break;
         
       case YALNIX_TTY_WRITE:
-        if (chk_str(uc->regs[1], uc->regs[2])) {
+        if (chk_buf(uc->regs[1], uc->regs[2], PROT_READ)) {
           TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to TTY_WRITE\n");
           retval = ERROR;
           break;
@@ -146,7 +134,7 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         break;
 
       case YALNIX_TTY_READ:
-        if (chk_str(uc->regs[1], uc->regs[2])) {
+        if (chk_buf(uc->regs[1], uc->regs[2], PROT_READ | PROT_WRITE)) {
           TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to TTY_READ\n");
           retval = ERROR;
           break;
@@ -159,6 +147,11 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         break;
 
       case YALNIX_CVAR_INIT:
+        if (chk_buf(uc->regs[0], sizeof(int), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
+          retval = ERROR;
+          break;
+        }
         retval = Yalnix_CvarInit((int*)uc->regs[0]);
         break;
 
@@ -174,19 +167,26 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         retval = Yalnix_CvarWait((int)uc->regs[0], (int)uc->regs[1]);
         break;
 
-      case YALNIX_LOCK_INIT:
-        if (chk_range(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer out of range\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_valid(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer to invalid page\n");
+      case YALNIX_SEM_INIT:
+        if (chk_buf(uc->regs[0], sizeof(int), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
           retval = ERROR;
           break;
         }
-        if (chk_rw(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: no read or write permissions for pointer argument\n");
+        retval = Yalnix_SemInit((int*)uc->regs[0], (int)uc->regs[1]);
+        break;
+
+      case YALNIX_SEM_UP:
+        retval = Yalnix_SemUp((int)uc->regs[0]);
+        break;
+
+      case YALNIX_SEM_DOWN:
+        retval = Yalnix_SemDown((int)uc->regs[0]);
+        break;
+
+      case YALNIX_LOCK_INIT:
+        if (chk_buf(uc->regs[0], sizeof(int), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
           retval = ERROR;
           break;
         }
@@ -203,18 +203,8 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
 
       case YALNIX_PIPE_INIT:
 
-        if (chk_range(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer out of range\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_valid(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: pointer to invalid page\n");
-          retval = ERROR;
-          break;
-        }
-        if (chk_rw(uc->regs[0])) {
-          TracePrintf(3, "\tSYSTEM CALL ERROR: no read or write permissions for pointer argument\n");
+        if (chk_buf(uc->regs[0], sizeof(int), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid pointer argument\n");
           retval = ERROR;
           break;
         }
@@ -225,7 +215,7 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
 
       case YALNIX_PIPE_READ:
 
-        if (chk_str(uc->regs[1], uc->regs[2])) {
+        if (chk_buf(uc->regs[1], uc->regs[2], PROT_READ | PROT_WRITE)) {
           TracePrintf(3, "\tSYSTEM CALL ERROR: invalid string buffer passed to PipeRead\n");
           retval = ERROR;
           break;
@@ -234,7 +224,7 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         break;
 
       case YALNIX_PIPE_WRITE:
-        if (chk_str(uc->regs[1], uc->regs[2])) {
+        if (chk_buf(uc->regs[1], uc->regs[2], PROT_READ)) {
           TracePrintf(3, "\tSYSTEM CALL ERROR: invalid string buffer passed to PipeWrite\n");
           retval = ERROR;
           break;
@@ -246,14 +236,126 @@ void HANDLE_TRAP_KERNEL(UserContext *uc) {
         retval = Yalnix_Reclaim((int)uc->regs[0]);
         break;        
 
+      case YALNIX_REGISTER:
+        retval = Yalnix_Register((unsigned int)uc->regs[0]);
+        break;
+
+      case YALNIX_SEND:
+        if (chk_buf(uc->regs[0], MESSAGE_SIZE, PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid message buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Send((void *)uc->regs[0], (int)uc->regs[1]);
+        break;
+
+      case YALNIX_RECEIVE:
+        if (chk_buf(uc->regs[0], MESSAGE_SIZE, PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid message buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Receive((void *)uc->regs[0]);
+        break;
+
+      case YALNIX_RECEIVESPECIFIC:
+        if (chk_buf(uc->regs[0], MESSAGE_SIZE, PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid message buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_ReceiveSpecific((void *)uc->regs[0], (int)uc->regs[1]);
+        break;
+
+      case YALNIX_REPLY:
+        if (chk_buf(uc->regs[0], MESSAGE_SIZE, PROT_READ)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid message buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Reply((void *)uc->regs[0], (int)uc->regs[1]);
+        break;
+
+      case YALNIX_FORWARD:
+        if (chk_buf(uc->regs[0], MESSAGE_SIZE, PROT_READ)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid message buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Forward((void *)uc->regs[0], (int)uc->regs[1], (int)uc->regs[2]);
+        break;
+
+      case YALNIX_COPY_FROM:
+        if (chk_buf(uc->regs[1], uc->regs[3], PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to CopyFrom\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_CopyFrom((int)uc->regs[0], (void *)uc->regs[1], (void *)uc->regs[2], (int)uc->regs[3]);
+        break;
+
+      case YALNIX_COPY_TO:
+        if (chk_buf(uc->regs[2], uc->regs[3], PROT_READ)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to CopyTo\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_CopyTo((int)uc->regs[0], (void *)uc->regs[1], (void *)uc->regs[2], (int)uc->regs[3]);
+        break;
+
+      case YALNIX_READ_SECTOR:
+        if (chk_buf(uc->regs[1], SECTORSIZE, PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to ReadSector\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_ReadSector((int)uc->regs[0], (void *)uc->regs[1]);
+        break;
+
+      case YALNIX_WRITE_SECTOR:
+        if (chk_buf(uc->regs[1], SECTORSIZE, PROT_READ)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid buffer passed to WriteSector\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_WriteSector((int)uc->regs[0], (void *)uc->regs[1]);
+        break;
+
+      case YALNIX_SYNC:
+        retval = Yalnix_Sync();
+        break;
+
+      case YALNIX_STATS:
+        if ((len = stats_size((int)uc->regs[0])) == ERROR) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: unknown stats selector %d\n", uc->regs[0]);
+          retval = ERROR;
+          break;
+        }
+        if (chk_buf(uc->regs[1], len, PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid stats buffer\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Stats((int)uc->regs[0], (void *)uc->regs[1], (int)uc->regs[2]);
+        break;
+
+      case YALNIX_BATCH:
+        if ((int) uc->regs[1] < 0 || (int) uc->regs[1] > BATCH_MAX ||
+            chk_buf(uc->regs[0], (int) uc->regs[1] * sizeof(batch_op_t), PROT_READ | PROT_WRITE)) {
+          TracePrintf(3, "\tSYSTEM CALL ERROR: invalid batch array\n");
+          retval = ERROR;
+          break;
+        }
+        retval = Yalnix_Batch(uc, (batch_op_t *)uc->regs[0], (int)uc->regs[1], (int)uc->regs[2]);
+        break;
+
       default:
         TracePrintf(3, "Unrecognized syscall: %d\n", uc->code);
+        retval = ERROR;
         break;
     } 
 
-    uc->regs[0] = retval;
-
-  
+    return retval;
 } 
 
 /* 
@@ -270,35 +372,16 @@ void HANDLE_TRAP_CLOCK(UserContext *uc) {
   // should implement round-robin process scheduling with 
   // cpu quantum per process of 1 clock tick
   
-  int i;
-  if (count_items(blocked_procs) > 0) {
-      ListNode *iterator = blocked_procs->first;
-
-    // Remove all the process that are no longer blocked from the blocked queue
-    iterator = blocked_procs->first;
-    while(iterator->next != NULL) {
-        PCB_t *data = iterator->data;
-        iterator = iterator->next;
-
-        // NOTE: This call to check_block auto-decrements the delay count
-        if (check_block(data->block) == UNBLOCKED) {
-          // Remove it from the blocked queue and add it to ready queue
-          remove_from_list(blocked_procs, data);
-          add_to_list(ready_procs, data, data->proc_id);
-        }
-    }
-    
-    // Check the last item in the list
-    if (check_block(((PCB_t *)iterator->data)->block) == UNBLOCKED) {
-      PCB_t *data = (PCB_t *) iterator->data;
-      remove_from_list(blocked_procs, data);
-      add_to_list(ready_procs, data, data->proc_id);
-    } 
-  }
-
-  // Are there more processes waiting?
+  // Wake whichever delayed processes are due this tick. Everything else
+  // that's blocked is woken by whatever it's blocked on.
+  current_tick++;
+  if (curr_proc == idle_proc)
+    kstats.idle_ticks++;
+  delay_expire(current_tick);
+
+  // Does the scheduler want someone else to run?
   TracePrintf(1, "Proc Id: %d\n", curr_proc->proc_id);
-  if (count_items(ready_procs) > 0) { 
+  if (sched_tick(curr_proc)) { 
     TracePrintf(1, "Switching processes\n");
     switch_to_next_available_proc(uc, 1);
   } else { 
@@ -339,14 +422,51 @@ void HANDLE_TRAP_MEMORY(UserContext *uc) {
 
   // Check if this is a permissions error
   if (uc->code == YALNIX_ACCERR) {
+      // A write to a copy-on-write page just needs its own copy of the page
+      if ((unsigned int) uc->addr >= VMEM_1_BASE &&
+          (unsigned int) uc->addr < VMEM_1_LIMIT) {
+        int cow_pg = (DOWN_TO_PAGE(uc->addr) - VMEM_1_BASE) >> PAGESHIFT;
+
+        if ((curr_proc->region1_info + cow_pg)->flags & PG_COW) {
+          if (cow_resolve(curr_proc, cow_pg) == SUCCESS) {
+            stats_fault(curr_proc, FAULT_COW);
+            TracePrintf(1, "End: HANDLE_TRAP_MEMORY (copy-on-write)\n");
+            return;
+          }
+
+          TracePrintf(3, "\tProcess %d could not copy a copy-on-write page\n",
+              curr_proc->proc_id);
+        }
+      }
+
       // Trace for the User
       TracePrintf(1, "Process %d had a permissions error at addr %p\n",
               curr_proc->proc_id, uc->code);
       
       // Abort the process
+      stats_fault(curr_proc, FAULT_FATAL);
       abort_current_process(ERROR, uc);
 
   } else if (uc->code == YALNIX_MAPERR) {
+    // A demand-paged page is being touched for the first time
+    if ((unsigned int) uc->addr >= VMEM_1_BASE &&
+        (unsigned int) uc->addr < VMEM_1_LIMIT) {
+      int lazy_pg = (DOWN_TO_PAGE(uc->addr) - VMEM_1_BASE) >> PAGESHIFT;
+
+      if ((curr_proc->region1_info + lazy_pg)->flags & PG_LAZY) {
+        if (lazy_fill(curr_proc, lazy_pg) == SUCCESS) {
+          stats_fault(curr_proc, FAULT_LAZY);
+          TracePrintf(1, "End: HANDLE_TRAP_MEMORY (demand paged)\n");
+          return;
+        }
+
+        TracePrintf(3, "\tProcess %d could not page in address %p\n",
+            curr_proc->proc_id, uc->addr);
+        stats_fault(curr_proc, FAULT_FATAL);
+        abort_current_process(ERROR, uc);
+      }
+    }
+
     // To decide whether this is a request to grow the stack or a genuine mapping
     // error, check if the offending address is b/t the break and the stack
     // pointer. If it is, assume, it's a request to grow the stack.
@@ -357,6 +477,7 @@ void HANDLE_TRAP_MEMORY(UserContext *uc) {
       TracePrintf(1, "Process %d had a mapping error \n", curr_proc->proc_id);
     
       // Abort the Process
+      stats_fault(curr_proc, FAULT_FATAL);
       abort_current_process(ERROR, uc);
     }
   }
@@ -368,14 +489,18 @@ void HANDLE_TRAP_MEMORY(UserContext *uc) {
   unsigned int usr_brk_pg = UP_TO_PAGE(curr_proc->brk_addr) >> PAGESHIFT;
   unsigned int usr_heap_base = curr_proc->heap_base_page;
   struct pte *temp_ent;
+  tlb_batch_t batch;
   int i;
 
+  tlb_batch_init(&batch);
+
   /* Check if the requested address would interfere with the heap */
   if (addr_pg - usr_brk_pg <= 2) {
       TracePrintf(3, "\tProcess %d does not have enough memory to grow the stack\n",
           curr_proc->proc_id, uc->code);
 
       // Abort the process
+      stats_fault(curr_proc, FAULT_FATAL);
       abort_current_process(ERROR, uc);
   }
 
@@ -387,26 +512,27 @@ void HANDLE_TRAP_MEMORY(UserContext *uc) {
       if (temp_ent->valid == (u_long) 0x0) {
 
         // Check that there are enough physical pages
-        if (count_items(&FrameList) <= 0) { /* This counting is inefficient... */
+        if (frames_available() <= 0) {
             TracePrintf(3, "\tProcess %d requested more memory for the stack, but there are not enough physical frames\n",
                     curr_proc->proc_id);
             
             // Abort the Process
+            stats_fault(curr_proc, FAULT_FATAL);
             abort_current_process(ERROR, uc);
         }
 
         // Allocate the pages
-        // Set it to valid with the proper permissions
-        temp_ent->valid = (u_long) 0x1;
-        temp_ent->prot = (u_long) (PROT_READ | PROT_WRITE);
-        // Get it a page
-        ListNode *node = pop(&FrameList);
-        temp_ent->pfn = (u_long) ((node->id * PAGESIZE) >> PAGESHIFT);
-        free(node);
+        // Set it to valid with the proper permissions, and get it a page
+        tlb_set_pte(&batch, temp_ent, (void *) (VMEM_1_BASE + (i << PAGESHIFT)),
+            (u_long) 0x1, (u_long) (PROT_READ | PROT_WRITE),
+            FNUM_TO_PFN(alloc_frame()));
+        (curr_proc->region1_info + i)->flags = 0;
       }
   }
   
-  WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL);
+  // Only the new stack pages changed
+  tlb_batch_flush(&batch);
+  stats_fault(curr_proc, FAULT_STACK);
   /* Is there anything I'm forgetting? */
   // otherwise imitate TRAP_ILLEGAL(uc)
   TracePrintf(1, "End: HANDLE_TRAP_MEMORY\n");
@@ -435,31 +561,15 @@ void HANDLE_TRAP_TTY_RECEIVE(UserContext *uc) {
 
   TracePrintf(1, "Start: Handle_trap_tty_receive\n");
   
-  int id = uc->code;
-  ListNode *tty_node = find_by_id(ttys, id);
-  TTY_t *tty = tty_node->data;
-  
-  buffer *new_buf = (buffer *)malloc(sizeof(buffer));
-  new_buf->buf = (char *)malloc(TERMINAL_MAX_LINE);
-  new_buf->len = TtyReceive(tty->id, new_buf->buf, TERMINAL_MAX_LINE);
-  int len = new_buf->len;
-  
-  // now that we've grabbed the text, let's store it: 
-  add_to_list(tty->buffers, new_buf, 0);
-  TracePrintf(1, "PID: %d Just TtyReceived - added buffer to list for someone to grab .\n", curr_proc->proc_id);
-  
-  // if a reader is waiting, let's wake him/her up:
-  List *readers = tty->readers;
-  ListNode *waiter_node;
-  PCB_t *waiter;
-  while (len > 0 && count_items(readers) > 0) {
-    waiter_node = pop(readers);
-    TracePrintf(1, "PID: %d Found a waiter - adding to ready queue. \n", curr_proc->proc_id);
-    waiter = waiter_node->data;
-    add_to_list(ready_procs, waiter, 0);
-    len = len - waiter->read_len;
-    free(waiter_node);
+  TTY_t *tty = tty_lookup(uc->code);
+
+  if (tty == NULL) {
+    TracePrintf(3, "Receive trap for unknown terminal %d\n", uc->code);
+    return;
   }
+  
+  // Move the line into the input ring and wake a reader for it
+  tty_received(tty);
 
   TracePrintf(1, "End: Handle_trap_tty_receive\n");
 } 
@@ -474,56 +584,23 @@ void HANDLE_TRAP_TTY_TRANSMIT(UserContext *uc) {
 
   TracePrintf(1, "Start: Handle_trap_tty_transmit\n");
   
-  int id = uc->code; 
-  ListNode *tty_node = find_by_id(ttys, id);
-  TTY_t *tty = tty_node->data;
-  
-  ListNode *writer_node = pop(tty->writers);
-  PCB_t *writer = writer_node->data;
-  free(writer_node);
-
-  // check if we need to write multiple times, and do so 
-  // otherwise, add this proc to ready_queue, and transmit 
-  // the next writer who's been waiting
-  int remaining_msg_len = writer->write_buf->len - TERMINAL_MAX_LINE;
-  if (remaining_msg_len > 0) { 
-    
-    // set remaining length and increment ptr in string
-    writer->write_buf->len = remaining_msg_len;
-    writer->write_buf->buf = writer->write_buf + TERMINAL_MAX_LINE;
-    add_to_list(tty->writers, writer, 0);
-    
-    if (remaining_msg_len > TERMINAL_MAX_LINE)
-      TtyTransmit(tty->id, writer->write_buf->buf, TERMINAL_MAX_LINE);
-    else 
-      TtyTransmit(tty->id, writer->write_buf->buf, writer->write_buf->len);
-    
-  } else { 
-    
-    // we're done, so throw this proc on ready queue
-    add_to_list(ready_procs, writer, writer->proc_id);
-    
-    // since we just trapped, we should check to see if anyone is waiting
-    ListNode *next_writer_node;
-    if (count_items(tty->writers) > 0) {
-      next_writer_node = pop(tty->writers);
-      PCB_t *next_writer = next_writer_node->data;
-      add_to_list(tty->writers, next_writer, 0);
-      if (next_writer->write_buf->len > TERMINAL_MAX_LINE)
-        TtyTransmit(tty->id, next_writer->write_buf->buf, TERMINAL_MAX_LINE);
-      else 
-        TtyTransmit(tty->id, next_writer->write_buf->buf, next_writer->write_buf->len);
-      free(next_writer_node);
-    } 
-    
+  TTY_t *tty = tty_lookup(uc->code);
+
+  if (tty == NULL) {
+    TracePrintf(3, "Transmit trap for unknown terminal %d\n", uc->code);
+    return;
   }
+
+  // Send the next chunk of the output ring, and let a writer waiting for
+  // room have some
+  tty_transmitted(tty);
   
   TracePrintf(1, "End: Handle_trap_tty_transmit\n");
 } 
 
 // To avoid errors by hardware
 void HANDLE_TRAP_DISK(UserContext *uc) { 
-  
+  disk_interrupt();
 }
 
 int chk_range(u_long ptr) {                                                         
@@ -533,54 +610,39 @@ int chk_range(u_long ptr) {
     return 0;                                                                       
 }                                                                                   
                                                                                     
-int chk_valid(u_long ptr){                                                          
-  struct pte *ptr_pte;
-  ptr_pte = curr_proc->region1_pt + (ptr >> PAGESHIFT) - 128;
-
-  if (ptr_pte->valid != (u_long) 0x1)
+/*
+ * Validates a buffer argument the kernel will access with prot
+ * (PROT_READ to read it, PROT_READ | PROT_WRITE to fill it in): loads or
+ * un-COWs its pages as needed and checks every page it touches, skipping
+ * the work if it's the same buffer the process passed last time. See
+ * check_user_range.
+ */
+int chk_buf(u_long ptr, int len, int prot) {
+  if (check_user_range(curr_proc, (void *) ptr, len, prot) != SUCCESS)
     return 1;
   else
     return 0;
-};                                                                                  
-                                                                                    
-int chk_read(u_long ptr) {                                                          
-  struct pte *ptr_pte;
-  ptr_pte = curr_proc->region1_pt + (ptr >> PAGESHIFT) - 128;
-
-  if (ptr_pte->prot | (u_long) PROT_READ)
-    return 0;
-  else
-    return 1;
-};                                                                                  
-                                                                                    
-int chk_write(u_long ptr) {                                                         
-  struct pte *ptr_pte;
-  ptr_pte = curr_proc->region1_pt + (ptr >> PAGESHIFT) - 128;
+}
 
-  if (ptr_pte->prot | (u_long) PROT_WRITE)
-    return 0;
-  else
-    return 1;
 
-};                                                                                  
-                                                                                    
-int chk_rw(u_long ptr) {                                                            
-  return (chk_write(ptr) || chk_read(ptr));
-};
+/*
+ * Loads and validates the pages holding Exec's filename, its argv array,
+ * and every string argv points to. These often live in not-yet-loaded
+ * text or data.
+ */
+int chk_exec_args(u_long fname, u_long argv) {
+  char **arg_p = (char **) argv;
 
-int chk_str(u_long ptr, int len) {
-  u_long start_ptr = ptr;
-  u_long end_ptr = ptr + len;
-  int i;
+  if (prepare_user_string(curr_proc, (char *) fname) != SUCCESS)
+    return 1;
 
-  for (i = 0; i < (len / PAGESIZE); i++) {
-    if (chk_range(ptr + (i * PAGESIZE)) ||
-        chk_valid(ptr + (i * PAGESIZE)) ||
-        chk_rw(ptr + (i * PAGESIZE))
-        )
+  while (1) {
+    if (check_user_range(curr_proc, (void *) arg_p, sizeof(char *), PROT_READ) != SUCCESS)
+      return 1;
+    if (*arg_p == NULL)
+      return 0;
+    if (prepare_user_string(curr_proc, *arg_p) != SUCCESS)
       return 1;
+    arg_p++;
   }
-
-  return 0;
 }
-
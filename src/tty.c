@@ -0,0 +1,278 @@
+/*
+ * File: tty.c
+ * Carter J. Bastian & KC Beard
+ * CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    Implementation of the terminal output rings declared in tty.h. The
+ *    TtyWrite and TtyRead syscalls themselves are in syscalls.c.
+ *
+ * To Do:
+ *
+ * Warnings:
+ *
+ */
+
+/* System Includes */
+#include <hardware.h>
+#include <yalnix.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local Includes */
+#include "kernel.h"
+#include "PCB.h"
+#include "tty.h"
+
+/*
+ * Private Variables
+ */
+static TTY_t ttys[NUM_TERMINALS];             // Every terminal, by id
+static char tty_rx_buf[TERMINAL_MAX_LINE];    // Where TtyReceive puts a line
+
+/*
+ * Public Function Definitions
+ */
+
+/*
+ * Function: init_ttys
+ *
+ * Sets up every terminal, each with an output ring of tty_out_capacity
+ * bytes rounded up to a power of two.
+ *
+ * Returns SUCCESS, or ERROR if the kernel heap ran out.
+ */
+int init_ttys() {
+  TTY_t *tty;
+  unsigned int cap;
+  int i;
+
+  for (cap = TTY_OUT_MIN; cap < tty_out_capacity && cap < TTY_OUT_LIMIT; cap <<= 1)
+    ;
+
+  for (i = 0; i < NUM_TERMINALS; i++) { 
+    tty = ttys + i;
+    bzero((char *) tty, sizeof(TTY_t));
+
+    tty->out_buf = (char *) malloc(cap);
+    if (tty->out_buf == NULL)
+      return ERROR;
+
+    init_queue(&tty->writers);
+    init_queue(&tty->readers);
+    tty->id = i;
+    tty->out_cap = cap;
+    tty->out_writer = NULL;
+    tty->stats.tty_id = i;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * Function: tty_lookup
+ *  @id: a terminal id passed in by a user program
+ *
+ * Returns the terminal, or NULL if there's no terminal with that id.
+ */
+TTY_t *tty_lookup(int id) {
+  if (id < 0 || id >= NUM_TERMINALS)
+    return NULL;
+
+  return ttys + id;
+}
+
+/*
+ * Function: tty_put
+ *  @tty: the terminal to write to
+ *  @src: bytes to queue
+ *  @len: number of bytes
+ *
+ * Copies as much as fits into the output ring, in at most two pieces.
+ *
+ * Returns the number of bytes queued.
+ */
+unsigned int tty_put(TTY_t *tty, char *src, unsigned int len) {
+  unsigned int off;
+  unsigned int first;
+
+  if (len > TTY_OUT_ROOM(tty))
+    len = TTY_OUT_ROOM(tty);
+
+  off = tty->out_tail & (tty->out_cap - 1);
+  first = (len < tty->out_cap - off) ? len : tty->out_cap - off;
+
+  memcpy(tty->out_buf + off, src, first);
+  memcpy(tty->out_buf, src + first, len - first);
+  tty->out_tail += len;
+
+  if (TTY_OUT_LEN_USED(tty) > tty->stats.out_queued_max)
+    tty->stats.out_queued_max = TTY_OUT_LEN_USED(tty);
+
+  return len;
+}
+
+/*
+ * Function: tty_start
+ *  @tty: a terminal
+ *
+ * If the terminal isn't transmitting and there's output queued, gathers
+ * as much of it as fits on a line (whoever wrote it, and across the wrap
+ * of the ring) into tx_buf and transmits it.
+ */
+void tty_start(TTY_t *tty) {
+  unsigned int off;
+  unsigned int len;
+  unsigned int first;
+
+  if (tty->out_sending > 0 || TTY_OUT_LEN_USED(tty) == 0)
+    return;
+
+  len = TTY_OUT_LEN_USED(tty);
+  if (len > TERMINAL_MAX_LINE)
+    len = TERMINAL_MAX_LINE;
+
+  off = tty->out_head & (tty->out_cap - 1);
+  first = (len < tty->out_cap - off) ? len : tty->out_cap - off;
+
+  memcpy(tty->tx_buf, tty->out_buf + off, first);
+  memcpy(tty->tx_buf + first, tty->out_buf, len - first);
+  tty->out_head += len;
+
+  tty->out_sending = len;
+  tty->tx_since = current_tick;
+  tty->stats.transmits++;
+  TtyTransmit(tty->id, tty->tx_buf, len);
+}
+
+/*
+ * Function: tty_transmitted
+ *  @tty: a terminal whose transmit just finished
+ *
+ * Starts the next transmit, and wakes the writer if it was waiting for
+ * room and now has what it asked for.
+ */
+void tty_transmitted(TTY_t *tty) {
+  unsigned int ticks = current_tick - tty->tx_since;
+
+  tty->stats.bytes_out += tty->out_sending;
+  tty->stats.tx_ticks += ticks;
+  if (ticks > tty->stats.tx_max_ticks)
+    tty->stats.tx_max_ticks = ticks;
+
+  tty->out_sending = 0;
+  tty_start(tty);
+
+  if (tty->out_waiting && TTY_OUT_ROOM(tty) >= tty->out_want) {
+    tty->out_waiting = 0;
+    make_ready(tty->out_writer, SCHED_WAKE_IO);
+  }
+}
+
+/*
+ * Function: tty_received
+ *  @tty: a terminal that has a line of input
+ *
+ * Moves the line into the input ring, marks where it ends, and wakes a
+ * reader for it.
+ */
+void tty_received(TTY_t *tty) {
+  unsigned int len;
+  unsigned int off;
+  unsigned int first;
+
+  len = TtyReceive(tty->id, tty_rx_buf, TERMINAL_MAX_LINE);
+  if (len == 0)
+    return;
+
+  if (len > TTY_IN_LEN - TTY_IN_LEN_USED(tty) || TTY_IN_LINE_COUNT(tty) == TTY_IN_LINES) {
+    TracePrintf(1, "tty_received: terminal %d input full, dropping %u bytes\n", tty->id, len);
+    tty->stats.bytes_dropped += len;
+    return;
+  }
+  tty->stats.bytes_in += len;
+
+  off = tty->in_tail & (TTY_IN_LEN - 1);
+  first = (len < TTY_IN_LEN - off) ? len : TTY_IN_LEN - off;
+
+  memcpy(tty->in_buf + off, tty_rx_buf, first);
+  memcpy(tty->in_buf, tty_rx_buf + first, len - first);
+  tty->in_tail += len;
+
+  tty->in_ends[tty->in_line_tail++ & (TTY_IN_LINES - 1)] = tty->in_tail;
+  tty_wake_readers(tty);
+}
+
+/*
+ * Function: tty_get
+ *  @tty: a terminal with a line waiting
+ *  @dest: where to put the bytes
+ *  @len: most bytes to take
+ *
+ * Takes up to @len bytes of the oldest line, which is only finished once
+ * all of it has been taken.
+ *
+ * Returns the number of bytes taken.
+ */
+unsigned int tty_get(TTY_t *tty, char *dest, unsigned int len) {
+  unsigned int end;
+  unsigned int off;
+  unsigned int first;
+
+  if (TTY_IN_LINE_COUNT(tty) == 0)
+    return 0;
+
+  end = tty->in_ends[tty->in_line_head & (TTY_IN_LINES - 1)];
+  if (len > end - tty->in_head)
+    len = end - tty->in_head;
+
+  off = tty->in_head & (TTY_IN_LEN - 1);
+  first = (len < TTY_IN_LEN - off) ? len : TTY_IN_LEN - off;
+
+  memcpy(dest, tty->in_buf + off, first);
+  memcpy(dest + first, tty->in_buf, len - first);
+  tty->in_head += len;
+
+  if (tty->in_head == end)
+    tty->in_line_head++;
+
+  return len;
+}
+
+/*
+ * Function: tty_wake_readers
+ *  @tty: a terminal
+ *
+ * Wakes blocked readers, oldest first, one for each line nobody has
+ * claimed yet.
+ */
+void tty_wake_readers(TTY_t *tty) {
+  PCB_t *reader;
+
+  while (TTY_IN_UNCLAIMED(tty) > 0 && (reader = dequeue(&tty->readers)) != NULL) {
+    tty->in_claimed++;
+    make_ready(reader, SCHED_WAKE_IO);
+  }
+}
+
+/*
+ * Function: tty_stats
+ *  @id: a terminal id
+ *  @ts: where to copy the terminal's counters
+ *
+ * Returns SUCCESS, or ERROR if there's no such terminal.
+ */
+int tty_stats(int id, ttystats_t *ts) {
+  TTY_t *tty = tty_lookup(id);
+
+  if (tty == NULL)
+    return ERROR;
+
+  *ts = tty->stats;
+  ts->out_queued = TTY_OUT_LEN_USED(tty) + tty->out_sending;
+  ts->in_queued = TTY_IN_LEN_USED(tty);
+  ts->readers = queue_count(&tty->readers);
+  ts->writers = queue_count(&tty->writers) + tty->out_waiting;
+
+  return SUCCESS;
+}
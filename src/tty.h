@@ -1,18 +1,127 @@
+/*
+ * File:  tty.h
+ *    Carter J. Bastian & KC Beard
+ *    CS58 15F, Yalnix Project
+ *
+ * Description:
+ *    The terminals. Output goes through a ring of tty_out_capacity bytes
+ *    per terminal: TtyWrite returns as soon as its bytes are in the ring
+ *    and only blocks while the ring is full. Every time a transmit
+ *    finishes, the next one gathers everything queued since, from however
+ *    many writers, up to TERMINAL_MAX_LINE bytes, so a burst of short
+ *    writes costs one transmit (and one trap) per line rather than one
+ *    per write.
+ *
+ *    Input goes into a ring of TTY_IN_LEN bytes per terminal, with the
+ *    end of every received line marked. TtyRead returns at most the rest
+ *    of the oldest line; whatever it doesn't take stays at the front for
+ *    the next TtyRead. Readers are served in the order they arrive, and
+ *    a received line wakes only as many of them as there are lines.
+ *
+ * Contents:
+ *    TTY_t               - A terminal
+ *    init_ttys()         - Create every terminal
+ *    tty_lookup()        - Find a terminal by id
+ *    tty_put()           - Copy bytes into a terminal's output ring
+ *    tty_start()         - Transmit what's queued if the terminal is idle
+ *    tty_transmitted()   - Account for a finished transmit
+ *    tty_received()      - Take a line from the terminal into the input ring
+ *    tty_get()           - Take bytes of the oldest line out of the ring
+ *    tty_wake_readers()  - Wake a reader for each line nobody's claimed
+ *    tty_stats()         - Copy out a terminal's counters
+ *
+ * Warnings:
+ *    The hardware reads the bytes it's transmitting until the transmit
+ *    trap, so they're copied out of the ring into tx_buf first, and
+ *    tx_buf isn't touched again until the trap.
+ *
+ *    Input that doesn't fit in the input ring (or comes when
+ *    TTY_IN_LINES lines are already waiting) is dropped.
+ */
+
 #ifndef _TTY_H_
 #define _TTY_H_
-#include "linked_list.h"
+#include <hardware.h>
+#include "queue.h"
+#include "stats.h"
+
+/*
+ * Public Constant Definitions
+ */
+// Default output ring size; change it with the -ttybuf kernel option
+#define TTY_OUT_LEN       4096
+
+// Output ring sizes are powers of two between these
+#define TTY_OUT_MIN       TERMINAL_MAX_LINE
+#define TTY_OUT_LIMIT     (1 << 16)
+
+// Bytes waiting in the output ring, and room left in it
+#define TTY_OUT_LEN_USED(tty)   ((tty)->out_tail - (tty)->out_head)
+#define TTY_OUT_ROOM(tty)       ((tty)->out_cap - TTY_OUT_LEN_USED(tty))
 
-typedef struct buffer { 
-  void *buf;  // starting logical addr
-  int len; // bytelength
-} buffer;
+// Input ring size and most lines it holds (both powers of two)
+#define TTY_IN_LEN        4096
+#define TTY_IN_LINES      64
 
+// Bytes and lines waiting in the input ring, and lines no reader has claimed
+#define TTY_IN_LEN_USED(tty)    ((tty)->in_tail - (tty)->in_head)
+#define TTY_IN_LINE_COUNT(tty)  ((tty)->in_line_tail - (tty)->in_line_head)
+#define TTY_IN_UNCLAIMED(tty)   (TTY_IN_LINE_COUNT(tty) - (tty)->in_claimed)
 
+/*
+ * Like a pipe's, the output ring's head and tail count every byte ever
+ * taken out and queued, and are masked down to an index into out_buf
+ * only when it's touched. Bytes leave the ring when they're copied into
+ * tx_buf to be transmitted, so the ring can refill during the transmit.
+ *
+ * One TtyWrite at a time owns the ring (out_writer), so its bytes come
+ * out together even when it has to wait for room; the rest wait in
+ * writers, oldest first. An owner waiting for room is woken once
+ * out_want bytes are free, not on every transmit.
+ *
+ * The input ring is counted the same way. in_ends holds where each
+ * waiting line ends (as an in_tail value), oldest at in_line_head. A
+ * reader woken for a line claims it (in_claimed) until it runs, so a
+ * reader that shows up in the meantime can't take it.
+ */
 typedef struct TTY_t { 
   int id; 
-  List *readers; 
-  List *writers; 
-  List *buffers;
+  proc_queue_t readers;   // Blocked in TtyRead, waiting for input
+  proc_queue_t writers;   // Blocked in TtyWrite, waiting for out_writer
+
+  char *out_buf;
+  unsigned int out_cap;         // Size of out_buf, a power of two
+  unsigned int out_head;        // Bytes taken out to transmit so far
+  unsigned int out_tail;        // Bytes queued so far
+  char tx_buf[TERMINAL_MAX_LINE];   // Bytes being transmitted
+  unsigned int out_sending;     // Bytes in tx_buf, or 0 if idle
+  unsigned int tx_since;        // Tick the transmit started
+  struct PCB_t *out_writer;     // TtyWrite in progress, or NULL
+  int out_waiting;              // 1 if out_writer is blocked for room
+  unsigned int out_want;        // Room out_writer is waiting for
+
+  char in_buf[TTY_IN_LEN];
+  unsigned int in_head;         // Bytes read so far
+  unsigned int in_tail;         // Bytes received so far
+  unsigned int in_ends[TTY_IN_LINES];
+  unsigned int in_line_head;    // Lines finished by readers so far
+  unsigned int in_line_tail;    // Lines received so far
+  unsigned int in_claimed;      // Lines promised to woken readers
+
+  ttystats_t stats;             // Counters (see stats.h)
 } TTY_t;
+
+/*
+ * Public Prototypes
+ */
+int init_ttys();
+TTY_t *tty_lookup(int id);
+unsigned int tty_put(TTY_t *tty, char *src, unsigned int len);
+void tty_start(TTY_t *tty);
+void tty_transmitted(TTY_t *tty);
+void tty_received(TTY_t *tty);
+unsigned int tty_get(TTY_t *tty, char *dest, unsigned int len);
+void tty_wake_readers(TTY_t *tty);
+int tty_stats(int id, ttystats_t *ts);
   
 #endif // _TTY_H_
@@ -0,0 +1,73 @@
+/*
+ * disk_bench.c
+ *    Concurrent readers hammering the disk, to measure sector throughput
+ *    and how much the elevator and request merging save. Each reader
+ *    reads sectors in its own pseudo-random order.
+ *
+ *    usage: disk_bench [readers [sectors_per_reader]]
+ */
+#include <yalnix.h>
+#include <hardware.h>
+#include "../src/stats.h"
+
+// argv[i] as a positive number, or dflt if it isn't one
+int parse(int argc, char *argv[], int i, int dflt) {
+  char *s;
+  int n = 0;
+
+  if (i >= argc)
+    return dflt;
+
+  s = argv[i];
+
+  while (*s >= '0' && *s <= '9')
+    n = n * 10 + (*s++ - '0');
+
+  return (n > 0) ? n : dflt;
+}
+
+int main(int argc, char *argv[]) {
+  int readers = parse(argc, argv, 1, 4);
+  int sectors = parse(argc, argv, 2, 200);
+  char buf[SECTORSIZE];
+  unsigned int seed;
+  int status, failed, ticks, i, j;
+  kstats_t before, after;
+
+  Custom0(STATS_KERNEL, (int) &before, 0, 0);
+
+  for (i = 0; i < readers; i++) {
+    if (Fork() == 0) {
+      seed = (unsigned int) (i + 1) * 2654435761u;
+      for (j = 0; j < sectors; j++) {
+        seed = seed * 1103515245 + 12345;
+        if (ReadSector((int) ((seed >> 8) % NUMSECTORS), buf) != 0)
+          Exit(ERROR);
+      }
+      Exit(0);
+    }
+  }
+
+  failed = 0;
+  for (i = 0; i < readers; i++) {
+    Wait(&status);
+    if (status != 0)
+      failed++;
+  }
+
+  Custom0(STATS_KERNEL, (int) &after, 0, 0);
+  ticks = after.ticks - before.ticks;
+
+  TtyPrintf(0, "disk_bench: %d readers read %d sectors in %d ticks (%d per 100 ticks)\n",
+      readers, readers * sectors, ticks,
+      (ticks > 0) ? readers * sectors * 100 / ticks : 0);
+  TtyPrintf(0, "disk_bench: %d disk reads, %d merged, %d sectors of seek\n",
+      after.disk_reads - before.disk_reads,
+      after.disk_merged - before.disk_merged,
+      after.disk_seek - before.disk_seek);
+  TtyPrintf(0, "disk_bench: buffer cache %d hits, %d misses\n",
+      after.bcache_hits - before.bcache_hits,
+      after.bcache_misses - before.bcache_misses);
+
+  Exit(failed ? ERROR : 0);
+}
@@ -0,0 +1,89 @@
+/*
+ * ipc_pingpong.c
+ *    The same round trip as pipe_pingpong, but with Send/Receive/Reply:
+ *    a child registered as a server echoes each message back, and any
+ *    payload past the message itself is moved with CopyFrom/CopyTo.
+ *
+ *    usage: ipc_pingpong [rounds [msglen]]
+ */
+#include <yalnix.h>
+#include "../src/stats.h"
+
+#define MAX_MSG   1024
+#define SERVER    1
+
+// The fixed-size message: where the rest of the payload lives
+typedef struct request_t {
+  char *buf;
+  int len;
+  char pad[MESSAGE_SIZE - sizeof(char *) - sizeof(int)];
+} request_t;
+
+// argv[i] as a positive number, or dflt if it isn't one
+int parse(int argc, char *argv[], int i, int dflt) {
+  char *s;
+  int n = 0;
+
+  if (i >= argc)
+    return dflt;
+
+  s = argv[i];
+
+  while (*s >= '0' && *s <= '9')
+    n = n * 10 + (*s++ - '0');
+
+  return (n > 0) ? n : dflt;
+}
+
+int main(int argc, char *argv[]) {
+  int rounds = parse(argc, argv, 1, 1000);
+  int len = parse(argc, argv, 2, 64);
+  char msg[MAX_MSG];
+  request_t req;
+  int pid, client, status, i;
+  kstats_t before, after;
+
+  if (len > MAX_MSG)
+    len = MAX_MSG;
+
+  if ((pid = Fork()) == 0) {
+    // Echo everything back
+    if (Register(SERVER) != 0)
+      Exit(ERROR);
+
+    for (i = 0; i < rounds; i++) {
+      if ((client = Receive(&req)) == ERROR ||
+          CopyFrom(client, msg, req.buf, req.len) != 0 ||
+          CopyTo(client, req.buf, msg, req.len) != 0 ||
+          Reply(&req, client) != 0)
+        Exit(ERROR);
+    }
+    Exit(0);
+  }
+
+  // Fill the payload after forking, so the server's CopyTo doesn't find
+  // it shared copy-on-write with the child
+  for (i = 0; i < len; i++)
+    msg[i] = (char) ('a' + i % 26);
+
+  Custom0(STATS_KERNEL, (int) &before, 0, 0);
+
+  for (i = 0; i < rounds; i++) {
+    req.buf = msg;
+    req.len = len;
+    if (Send(&req, pid) != 0) {
+      TtyPrintf(0, "ipc_pingpong: round %d failed\n", i);
+      Exit(ERROR);
+    }
+  }
+
+  Custom0(STATS_KERNEL, (int) &after, 0, 0);
+  Wait(&status);
+
+  TtyPrintf(0, "ipc_pingpong: %d rounds of %d bytes in %d ticks, %d switches\n",
+      rounds, len, after.ticks - before.ticks,
+      (after.switches_voluntary + after.switches_involuntary) -
+      (before.switches_voluntary + before.switches_involuntary));
+
+  Exit(status);
+}
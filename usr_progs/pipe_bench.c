@@ -0,0 +1,153 @@
+/*
+ * pipe_bench.c
+ *    Several producers and consumers streaming through one pipe. Each
+ *    producer writes bytes bytes in chunk-sized writes and each consumer
+ *    reads an equal share back in chunk-sized reads; consumers exit with
+ *    the sum of what they read so the parent can check nothing was lost.
+ *
+ *    usage: pipe_bench [producers [consumers [bytes [chunk]]]]
+ *
+ *    chunk has to fit in the pipe (see the kernel's -pipesz option).
+ *    With no arguments it runs 2 producers and 2 consumers, then 6
+ *    producers and 2 consumers moving a whole pipe per write.
+ */
+#include <yalnix.h>
+#include "../src/stats.h"
+
+#define MAX_CHUNK   4096
+#define MAX_PIPE_BYTES  1024    // The kernel's default pipe size
+
+// argv[i] as a positive number, or dflt if it isn't one
+int parse(int argc, char *argv[], int i, int dflt) {
+  char *s;
+  int n = 0;
+
+  if (i >= argc)
+    return dflt;
+
+  s = argv[i];
+
+  while (*s >= '0' && *s <= '9')
+    n = n * 10 + (*s++ - '0');
+
+  return (n > 0) ? n : dflt;
+}
+
+// Producer p's i-th byte
+char pattern(int p, int i) {
+  return (char) ((p * 31 + i) & 0x7f);
+}
+
+void produce(int pipe_id, int p, int bytes, int chunk) {
+  char buf[MAX_CHUNK];
+  int sent, n, i;
+
+  for (sent = 0; sent < bytes; sent += n) {
+    n = (bytes - sent < chunk) ? bytes - sent : chunk;
+    for (i = 0; i < n; i++)
+      buf[i] = pattern(p, sent + i);
+
+    if (PipeWrite(pipe_id, buf, n) != n)
+      Exit(ERROR);
+  }
+
+  Exit(0);
+}
+
+void consume(int pipe_id, int bytes, int chunk) {
+  char buf[MAX_CHUNK];
+  int got, n, i;
+  int sum = 0;
+
+  for (got = 0; got < bytes; got += n) {
+    n = (bytes - got < chunk) ? bytes - got : chunk;
+    if (PipeRead(pipe_id, buf, n) != n)
+      Exit(ERROR);
+
+    for (i = 0; i < n; i++)
+      sum += buf[i];
+  }
+
+  Exit(sum);
+}
+
+/*
+ * One run of the benchmark. Returns 0 if the consumers got back exactly
+ * what the producers wrote, ERROR otherwise.
+ */
+int run(int producers, int consumers, int bytes, int chunk) {
+  int share, expected, sum, status, i, p;
+  int pipe_id;
+  kstats_t before, after;
+
+  if (chunk > MAX_CHUNK)
+    chunk = MAX_CHUNK;
+
+  // Every consumer reads the same amount
+  if (bytes >= consumers)
+    bytes -= bytes % consumers;
+  share = (producers * bytes) / consumers;
+
+  expected = 0;
+  for (p = 0; p < producers; p++) {
+    for (i = 0; i < bytes; i++)
+      expected += pattern(p, i);
+  }
+
+  if (PipeInit(&pipe_id) != 0) {
+    TtyPrintf(0, "pipe_bench: PipeInit failed\n");
+    return ERROR;
+  }
+
+  TtyPrintf(0, "pipe_bench: %d producers x %d bytes, %d consumers, chunk %d\n",
+      producers, bytes, consumers, chunk);
+  Custom0(STATS_KERNEL, (int) &before, 0, 0);
+
+  for (p = 0; p < producers; p++) {
+    if (Fork() == 0)
+      produce(pipe_id, p, bytes, chunk);
+  }
+  for (i = 0; i < consumers; i++) {
+    if (Fork() == 0)
+      consume(pipe_id, share, chunk);
+  }
+
+  // Producers exit with 0, so the statuses sum to what the consumers read
+  sum = 0;
+  for (i = 0; i < producers + consumers; i++) {
+    Wait(&status);
+    if (status == ERROR) {
+      TtyPrintf(0, "pipe_bench: a child failed\n");
+      return ERROR;
+    }
+    sum += status;
+  }
+
+  Custom0(STATS_KERNEL, (int) &after, 0, 0);
+
+  TtyPrintf(0, "pipe_bench: %s, %d bytes in %d ticks\n",
+      (sum == expected) ? "ok" : "CHECKSUM MISMATCH",
+      producers * bytes, after.ticks - before.ticks);
+  TtyPrintf(0, "pipe_bench: %d voluntary / %d involuntary switches, %d idle ticks\n",
+      after.switches_voluntary - before.switches_voluntary,
+      after.switches_involuntary - before.switches_involuntary,
+      after.idle_ticks - before.idle_ticks);
+
+  Reclaim(pipe_id);
+  return (sum == expected) ? 0 : ERROR;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    Exit(run(parse(argc, argv, 1, 2), parse(argc, argv, 2, 2),
+          parse(argc, argv, 3, 16384), parse(argc, argv, 4, 256)));
+  }
+
+  if (run(2, 2, 16384, 256) != 0)
+    Exit(ERROR);
+
+  // More writers than the pipe can make room for at once, each writing a
+  // whole default-sized pipe at a time, so writers queue up behind each
+  // other while readers are also queued
+  Exit(run(6, 2, 8192, MAX_PIPE_BYTES));
+}
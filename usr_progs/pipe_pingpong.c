@@ -0,0 +1,76 @@
+/*
+ * pipe_pingpong.c
+ *    Two processes bouncing a message back and forth over a pair of
+ *    pipes, to measure the cost of a blocking pipe round trip.
+ *
+ *    usage: pipe_pingpong [rounds [msglen]]
+ */
+#include <yalnix.h>
+#include "../src/stats.h"
+
+#define MAX_MSG   1024
+
+// argv[i] as a positive number, or dflt if it isn't one
+int parse(int argc, char *argv[], int i, int dflt) {
+  char *s;
+  int n = 0;
+
+  if (i >= argc)
+    return dflt;
+
+  s = argv[i];
+
+  while (*s >= '0' && *s <= '9')
+    n = n * 10 + (*s++ - '0');
+
+  return (n > 0) ? n : dflt;
+}
+
+int main(int argc, char *argv[]) {
+  int rounds = parse(argc, argv, 1, 1000);
+  int len = parse(argc, argv, 2, 64);
+  char msg[MAX_MSG];
+  int ping, pong, status, i;
+  kstats_t before, after;
+
+  if (len > MAX_MSG)
+    len = MAX_MSG;
+
+  if (PipeInit(&ping) != 0 || PipeInit(&pong) != 0) {
+    TtyPrintf(0, "pipe_pingpong: PipeInit failed\n");
+    Exit(ERROR);
+  }
+
+  for (i = 0; i < len; i++)
+    msg[i] = (char) ('a' + i % 26);
+
+  if (Fork() == 0) {
+    // Echo everything back
+    for (i = 0; i < rounds; i++) {
+      if (PipeRead(ping, msg, len) != len || PipeWrite(pong, msg, len) != len)
+        Exit(ERROR);
+    }
+    Exit(0);
+  }
+
+  Custom0(STATS_KERNEL, (int) &before, 0, 0);
+
+  for (i = 0; i < rounds; i++) {
+    if (PipeWrite(ping, msg, len) != len || PipeRead(pong, msg, len) != len) {
+      TtyPrintf(0, "pipe_pingpong: round %d failed\n", i);
+      Exit(ERROR);
+    }
+  }
+
+  Custom0(STATS_KERNEL, (int) &after, 0, 0);
+  Wait(&status);
+
+  TtyPrintf(0, "pipe_pingpong: %d rounds of %d bytes in %d ticks, %d switches\n",
+      rounds, len, after.ticks - before.ticks,
+      (after.switches_voluntary + after.switches_involuntary) -
+      (before.switches_voluntary + before.switches_involuntary));
+
+  Reclaim(ping);
+  Reclaim(pong);
+  Exit(status);
+}